@@ -1,4 +1,5 @@
   #include "raylib.h"
+  #include "rlgl.h"
   #include <vector>
   #include <cmath>
   #include <string>
@@ -6,17 +7,50 @@
   #include <random>
   #include <memory>
   #include <ctime>
+  #include <cstdint>
+  #include <chrono>
+  #include <cstdio>
+  #include <cstdlib>
+  #include <cstring>
+  #include <thread>
+  #include <mutex>
+  #include <condition_variable>
+  #include <atomic>
+  #include <new>
+
+  // The simulation must round the same under any build flags, or replays and the
+  // kernel sets drift apart, so multiply-adds are never fused into FMA
+  #if defined(__clang__)
+  #pragma STDC FP_CONTRACT OFF
+  #elif defined(__GNUC__)
+  #pragma GCC optimize("fp-contract=off")
+  #endif
+
+  // x86 builds get SSE2/AVX2 integration kernels, picked at runtime by SelectKernels
+  #if defined(__SSE2__)
+  #include <immintrin.h>
+  #define COMETS_X86_SIMD 1
+  #endif
+
+  // Random number generation utilities. The simulation draws from *rng, so a
+  // host can seed it or point it at its own engine; purely visual randomness
+  // takes its own engine so it never shifts the simulation's sequence.
+  std::mt19937 defaultRng(std::time(nullptr));
+  std::mt19937* rng = &defaultRng;
+  std::mt19937 visualRng(std::time(nullptr));
+
+  void SeedRandom(uint32_t seed) {
+      rng->seed(seed);
+  }
 
-  // Random number generation utilities
-  std::mt19937 rng(std::time(nullptr));
-  float RandomRange(float min, float max) {
+  float RandomRange(float min, float max, std::mt19937& engine = *rng) {
       std::uniform_real_distribution<float> dist(min, max);
-      return dist(rng);
+      return dist(engine);
   }
 
-  int RandomInt(int min, int max) {
+  int RandomInt(int min, int max, std::mt19937& engine = *rng) {
       std::uniform_int_distribution<int> dist(min, max);
-      return dist(rng);
+      return dist(engine);
   }
 
   // Game constants
@@ -45,8 +79,12 @@
   const int COMET_SPAWN_BATCH_MIN = 1;
   const int COMET_SPAWN_BATCH_MAX = 3;
   const float COMET_MIN_SPEED = 250.0f;
+  const int COMET_SEGMENTS = 12;             // outline points, more for rounder comets
+  const int COMET_TRAIL_LENGTH = 5;
+  const float COMET_TRAIL_INTERVAL = 0.05f;  // sec between trail points
 
   // Big comets
+  const int BIG_COMET_SEGMENTS = 18;
   const float BIG_COMET_SPAWN_INTERVAL = 25.0f;
   const int BIG_COMET_SPAWN_MAX = 1;
   const float BIG_COMET_SPEED_MIN = 150.0f;
@@ -61,6 +99,85 @@
 
   // Star field constants
   const int NUM_STARS = 500;
+  const int STAR_BATCH = 1024;               // star sprites submitted per rlgl batch check
+
+  // Comet shape cache constants
+  const int SHAPE_TEMPLATES = 256;           // outlines pre-generated per segment count
+  const uint32_t SHAPE_SEED = 0xc0e7u;       // fixed, so a shapeId looks the same in every run
+  const int MORPH_LUT_SIZE = 1024;           // sin samples per turn, a power of two
+  const int TRAIL_SEGMENTS = 24;             // triangles per trail disc
+
+  // Particle pool constants
+  const int MAX_PARTICLES = 8192;            // pool size; spawning past it recycles live slots
+  const int PARTICLE_BATCH = 1024;           // quads submitted per rlgl batch check
+
+  // Broad-phase collision grid constants
+  const int GRID_CELL_SIZE = 64;
+  const int GRID_COLS = (SCREEN_WIDTH + GRID_CELL_SIZE - 1) / GRID_CELL_SIZE;
+  const int GRID_ROWS = (SCREEN_HEIGHT + GRID_CELL_SIZE - 1) / GRID_CELL_SIZE;
+  const float GRID_MARGIN = 8.0f;                // how far an entity may be pushed before it leaves its box
+  const float GRID_SCAN_COST = 4.0f;             // brute-force pair checks one grid entry scan costs, requeries included
+
+  // Job system constants
+  const int MAX_WORKERS = 15;                    // pool threads, besides the main and simulation threads
+  const int JOB_QUEUE_SIZE = 256;                // jobs each worker's queue holds
+  // Fewest entities worth a job of their own, per pass. Waking a worker costs
+  // tens of microseconds, about what integrating a thousand comets does, so
+  // smaller ranges run inline. Multiples of 8 keep slices whole AVX2 registers.
+  const int STAR_GRAIN = 4096;
+  const int PARTICLE_GRAIN = 4096;
+  const int BULLET_GRAIN = 4096;
+  const int COMET_GRAIN = 1024;                  // comets also push trail points, so fewer per job
+
+  // Profiler constants
+  const int PROFILE_RING_SIZE = 16384;           // zones kept per thread
+  const int PROFILE_TRACE_FRAMES = 300;          // frames a trace dump covers
+  const int PROFILE_HUD_FRAMES = 30;             // frames the HUD averages over
+  const int PROFILE_MAX_ZONES = 32;              // distinct zones the HUD tracks
+
+  // Replay constants. Live play advances in steps of FIXED_DT, so a recorded
+  // run replays tick for tick.
+  const float FIXED_DT = 1.0f / 60.0f;
+  const int MAX_TICKS_PER_FRAME = 5;             // a longer stall drops time instead of catching up
+  const char REPLAY_MAGIC[4] = { 'S', 'C', 'R', 'P' };
+  const uint32_t REPLAY_VERSION = 3;             // bump with any change to what Update does
+  const long REPLAY_SNAPSHOT_INTERVAL = 600;     // ticks between the snapshots seeks restart from
+  const long REPLAY_SEEK_STEP = 600;
+
+  // Build with -DCOMETS_VERIFY_BROADPHASE=1 to run every collision pass through both
+  // the grid and the brute-force scans and log any difference in the outcome
+  #ifndef COMETS_VERIFY_BROADPHASE
+  #define COMETS_VERIFY_BROADPHASE 0
+  #endif
+
+  // Build with -DCOMETS_HEADLESS to replace the game with a windowless simulation
+  // benchmark (see RunHeadless)
+
+  // Time the rest of the enclosing scope as a profiler zone. Zone names must be
+  // string literals.
+  #define PROFILE_CONCAT_INNER(a, b) a##b
+  #define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+  #define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+
+  // Player input for one tick, a bitmask of these buttons
+  enum InputButton {
+      INPUT_THRUST = 1 << 0,
+      INPUT_REVERSE = 1 << 1,
+      INPUT_BRAKE = 1 << 2,
+      INPUT_LEFT = 1 << 3,
+      INPUT_RIGHT = 1 << 4
+  };
+  typedef uint8_t InputCommand;
+
+  // Sounds the simulation asks for; the frontend decides whether to play them
+  enum SoundEvent {
+      SOUND_BULLET,
+      SOUND_HIT,
+      SOUND_EXPLOSION,
+      SOUND_POWERUP,
+      SOUND_VICTORY,
+      SOUND_DEFEAT
+  };
 
   // Game states
   enum GameState {
@@ -71,33 +188,80 @@
       WIN
   };
 
+  // Timed parts of a frame, for seeing how the pipeline scales
+  enum PipelineStage {
+      STAGE_TICK,          // all of one Update
+      STAGE_INTEGRATE,     // bullets, comets and big comets
+      STAGE_PARTICLES,
+      STAGE_BROAD_PHASE,
+      STAGE_COLLISIONS,    // collision passes, then spawning and flushing kills
+      STAGE_STARFIELD,
+      STAGE_PUBLISH,       // copying a tick out for drawing
+      STAGE_DRAW,
+      STAGE_WAIT,          // main thread blocked on the simulation thread
+      STAGE_COUNT
+  };
+
+  const char* const STAGE_NAMES[STAGE_COUNT] = {
+      "tick", "integrate", "particles", "broad phase", "collisions", "starfield", "publish", "draw", "wait"
+  };
+
   // Forward declarations of structures
   struct CometShapePoint;
-  struct Star;
+  struct StarField;
   struct Spark;
-  struct Bullet;
-  struct ExplosionParticle;
+  struct ParticleStore;
   struct Spaceship;
-  struct Comet;
-  struct BigComet;
-  struct PowerUp;
+  struct TrailPoint;
+  struct CometTrail;
+  struct CometShape;
+  struct BigCometShape;
+  struct EntityHandle;
+  struct HandleTable;
+  struct CometStore;
+  struct BigCometStore;
+  struct BulletStore;
+  struct PowerUpStore;
+  struct GridEntry;
+  struct SpatialGrid;
+  struct IntegrationKernels;
+  struct ReplayHeader;
+  struct ReplayRecorder;
+  struct SimulationSnapshot;
+  struct ReplayPlayback;
+  struct Job;
+  struct JobQueue;
+  struct JobSystem;
+  struct ProfileEvent;
+  struct ProfileThread;
+  struct ProfileZone;
+  struct ProfileZoneStats;
+  struct Profiler;
+  struct StageTimes;
+  struct StageTimer;
+  struct SimulationThread;
+  struct FrameSnapshot;
 
   // Structure definitions
   struct CometShapePoint {
       float angle;
+      float cosAngle;
+      float sinAngle;
       float factor;
       float frequency;
       float phase;
   };
 
-  struct Star {
-      float x;
-      float y;
-      float baseSize;
-      float sizeVariation;
-      float sizeSpeed;
-      float sizeTime;
-      bool flicker;
+  // Stars, one column per field. Steady stars have a zero sizeSpeed, so
+  // advancing every sizeTime leaves theirs untouched.
+  struct StarField {
+      std::vector<float> x;
+      std::vector<float> y;
+      std::vector<float> baseSize;
+      std::vector<float> sizeVariation;
+      std::vector<float> sizeSpeed;
+      std::vector<float> sizeTime;
+      std::vector<char> flicker;
   };
 
   struct Spark {
@@ -106,18 +270,18 @@
       float lifetime;
   };
 
-  struct Bullet {
-      Vector2 position;
-      Vector2 velocity;
-      float radius;
-  };
-
-  struct ExplosionParticle {
-      Vector2 position;
-      Vector2 velocity;
-      float lifetime;
-      float size;
-      Color color;
+  // Fixed pool of explosion particles, one column per field. The first count
+  // slots are live; expiring one moves the last live particle into its slot.
+  struct ParticleStore {
+      float posX[MAX_PARTICLES];
+      float posY[MAX_PARTICLES];
+      float velX[MAX_PARTICLES];
+      float velY[MAX_PARTICLES];
+      float lifetime[MAX_PARTICLES];
+      float size[MAX_PARTICLES];
+      Color color[MAX_PARTICLES];
+      int count;
+      int recycle;      // next slot overwritten while the pool is full
   };
 
   struct Spaceship {
@@ -127,6 +291,7 @@
       float size;
       int hitPoints;
       float hitFlashTimer;
+      bool thrusting;
   };
 
   struct TrailPoint {
@@ -134,54 +299,347 @@
       float y;
   };
 
-  struct Comet {
-      Vector2 position;
-      Vector2 velocity;
-      float radius;
-      int tier;
-      Color color;
-      int hitPoints;
-      float hitEffectTimer;
-      float slowEffectTimer;
-      float indestructableTimer;
-      float oldVX;
-      float oldVY;
-      std::vector<TrailPoint> trail;
-      float trailTimer;
-      std::vector<CometShapePoint> shape;
-      float rotationSpeed;
-      bool morph;
+  // Last few positions of a comet, oldest first
+  struct CometTrail {
+      TrailPoint points[COMET_TRAIL_LENGTH];
+      int count;
   };
 
-  struct BigComet {
-      Vector2 position;
-      Vector2 velocity;
-      float radius;
-      Color color;
-      std::vector<CometShapePoint> shape;
-      std::vector<TrailPoint> trail;
-      float trailTimer;
-      bool morph;
-      float rotationSpeed;
+  // Outline templates, shared through the shape cache
+  struct CometShape {
+      CometShapePoint points[COMET_SEGMENTS];
   };
 
-  struct PowerUp {
-      Vector2 position;
-      Vector2 velocity;
-      float lifetime;
-      float radius;
+  struct BigCometShape {
+      CometShapePoint points[BIG_COMET_SEGMENTS];
+  };
+
+  // Stable reference to an entity in one of the stores. Its dense index changes
+  // when another entity is swapped into a removed one's place; the handle does
+  // not, and goes stale once its own entity is removed.
+  struct EntityHandle {
+      uint32_t slot;
+      uint32_t generation;
+  };
+
+  // Slot bookkeeping shared by the entity stores. Entities killed during an update
+  // stay in the dense columns, flagged, until FlushKills swaps them out at the end
+  // of it, so indices taken anywhere in the update stay valid.
+  struct HandleTable {
+      std::vector<uint32_t> denseToSlot;
+      std::vector<char> killed;           // per dense index
+      std::vector<uint32_t> slotToDense;
+      std::vector<uint32_t> generations;
+      std::vector<uint32_t> freeSlots;
+      std::vector<uint32_t> killList;     // slots to remove, in kill order
+  };
+
+  // Entity stores keep one dense column per field, so passes over a single
+  // field walk contiguous memory
+  struct CometStore {
+      std::vector<float> posX;
+      std::vector<float> posY;
+      std::vector<float> velX;
+      std::vector<float> velY;
+      std::vector<float> radius;
+      std::vector<float> hitEffectTimer;
+      std::vector<float> slowEffectTimer;
+      std::vector<float> indestructableTimer;
+      std::vector<float> trailTimer;
+      std::vector<float> rotationSpeed;
+      std::vector<int> tier;
+      std::vector<int> hitPoints;
+      std::vector<Color> color;
+      std::vector<char> morph;
+      std::vector<CometTrail> trail;
+      std::vector<uint16_t> shapeId;      // index into cometShapes
+      HandleTable handles;
+  };
+
+  struct BigCometStore {
+      std::vector<float> posX;
+      std::vector<float> posY;
+      std::vector<float> velX;
+      std::vector<float> velY;
+      std::vector<float> radius;
+      std::vector<float> rotationSpeed;
+      std::vector<Color> color;
+      std::vector<char> morph;
+      std::vector<uint16_t> shapeId;      // index into bigCometShapes
+      HandleTable handles;
+  };
+
+  struct BulletStore {
+      std::vector<float> posX;
+      std::vector<float> posY;
+      std::vector<float> velX;
+      std::vector<float> velY;
+      std::vector<float> radius;
+      HandleTable handles;
+  };
+
+  struct PowerUpStore {
+      std::vector<float> posX;
+      std::vector<float> posY;
+      std::vector<float> velX;
+      std::vector<float> velY;
+      std::vector<float> lifetime;
+      std::vector<float> radius;
+      HandleTable handles;
+  };
+
+  // Entity box as binned into a grid cell
+  struct GridEntry {
+      float x;
+      float y;
+      float halfSize;   // entity radius plus GRID_MARGIN
+      int item;
+  };
+
+  // Uniform grid over the playfield, stored as per-cell buckets of entity boxes.
+  // Each entity is binned by its bounding box grown by GRID_MARGIN, so it stays
+  // findable until it is pushed further than that from where it was binned. An
+  // entity pushed out of its box is binned again into per-cell lists of moves.
+  struct SpatialGrid {
+      std::vector<int> cellStart;      // bucket offsets into cellEntries, one per cell plus end
+      std::vector<int> cellEnd;        // bucket ends; queries swap stale entries past them
+      std::vector<GridEntry> cellEntries;
+      std::vector<float> builtX;       // where each entity was last binned
+      std::vector<float> builtY;
+      std::vector<float> halfSize;
+      std::vector<char> moved;         // binned again since the build, so its cellEntries are stale
+      std::vector<int> movedHead;      // per cell, the latest moveEntries entry in it; -1 if none
+      std::vector<int> moveNext;       // per moveEntries entry, the one before it in its cell
+      std::vector<GridEntry> moveEntries;
+      std::vector<int> latestMove;     // per entity, its first entry from the latest binning
+      std::vector<uint64_t> queryMask; // one bit per item, dedupes and orders query results
+      int builtCount = 0;
+      float queryScans = 0;            // entries a query is expected to scan
+  };
+
+  // Integration loops for one instruction set. Every set rounds exactly like the
+  // scalar one (none of them fuse multiply-adds), so which set runs never changes
+  // the simulation.
+  struct IntegrationKernels {
+      const char* name;
+      void (*integrateComets)(float* posX, float* posY, float* velX, float* velY, const float* radius, int count, float dt);
+      void (*integrateParticles)(float* posX, float* posY, const float* velX, const float* velY, float* lifetime, float* size, int count, float dt);
+      void (*advance)(float* value, const float* rate, int count, float dt);   // value += rate * dt
+  };
+
+  // Replay file header, followed by one InputCommand byte per tick. Fields are
+  // written raw (little-endian); tickCount, finalScore and checksum are patched
+  // in when the recording closes, so a file the game never closed has zeros there.
+  struct ReplayHeader {
+      char magic[4];
+      uint32_t version;
+      uint32_t seed;
+      float dt;
+      uint32_t tickCount;
+      int32_t finalScore;
+      uint32_t checksum;   // SimulationChecksum after the last tick
+  };
+  static_assert(sizeof(ReplayHeader) == 28, "replay header must stay unpadded");
+
+  // Replay being written during play
+  struct ReplayRecorder {
+      FILE* file = nullptr;
+      ReplayHeader header;
+  };
+
+  // Everything Update carries from one tick to the next. Explosion particles
+  // are left out, since they never feed back into the simulation.
+  struct SimulationSnapshot {
+      GameState gameState;
+      Spaceship ship;
+      BulletStore bullets;
+      std::vector<Spark> sparks;
+      CometStore comets;
+      BigCometStore bigComets;
+      PowerUpStore powerUps;
+      float gameTime;
+      float lastBulletTime;
+      float cometSpawnTimer;
+      float bigCometSpawnTimer;
+      float powerUpSpawnTimer;
+      int score;
+      bool winTriggered;
+      std::mt19937 rng;
+  };
+
+  // One slice of a ParallelFor range
+  struct Job {
+      void (*run)(void* body, int begin, int end);
+      void* body;
+      int begin;
+      int end;
+      std::atomic<int>* pending;   // slices of the range not yet finished
+  };
+
+  // Ring of jobs owned by one worker. The owner takes from the back, other
+  // threads steal from the front.
+  struct JobQueue {
+      std::mutex mutex;
+      Job jobs[JOB_QUEUE_SIZE];
+      int head = 0;
+      int count = 0;
+  };
+
+  // Work-stealing pool. A thread calling ParallelFor deals slices out to the
+  // worker queues and steals them back while it waits, so it never idles.
+  struct JobSystem {
+      std::vector<std::thread> workers;
+      std::unique_ptr<JobQueue[]> queues;   // one per worker
+      int queueCount = 0;
+      std::atomic<int> queued{0};
+      std::mutex sleepMutex;
+      std::condition_variable wake;
+      bool quit = false;                    // guarded by sleepMutex
+  };
+
+  // A finished zone, times in nanoseconds since the profiler's epoch
+  struct ProfileEvent {
+      const char* name;
+      int64_t start;
+      int64_t end;
+  };
+
+  // Zones finished on one thread, in the order they ended. Only the owning
+  // thread writes; readers stay in the newer half of the ring, which the writer
+  // will not reach again for thousands of zones.
+  struct ProfileThread {
+      ProfileEvent events[PROFILE_RING_SIZE];
+      std::atomic<uint64_t> written{0};
+      int id;
+      char name[24];
+  };
+
+  // Records the time from its construction to its destruction, or to End
+  struct ProfileZone {
+      const char* name;
+      int64_t start;
+      bool open;
+
+      explicit ProfileZone(const char* name);
+      ~ProfileZone();
+      void End();
+  };
+
+  // One zone's share of the HUD: totals over the current window, and the
+  // per-frame means of the last full one
+  struct ProfileZoneStats {
+      const char* name;
+      double windowMs;
+      int windowCalls;
+      float ms;
+      float calls;
+  };
+
+  struct Profiler {
+      std::mutex threadsMutex;
+      std::vector<std::unique_ptr<ProfileThread>> threads;
+      int64_t frameMarks[PROFILE_TRACE_FRAMES + 1];   // frame end times, frame k at k % size
+      long frames = 0;
+
+      ProfileZoneStats zones[PROFILE_MAX_ZONES];
+      int zoneCount = 0;
+      int windowFrames = 0;
+      double windowFrameMs = 0;
+      long windowAllocations = 0;
+      long allocationsAtMark = 0;
+      float frameMs = 0;
+      float allocationsPerFrame = 0;
+      bool hudVisible = false;
+  };
+
+  // Time spent per stage since startup. Each stage is only ever timed on one
+  // thread at a time.
+  struct StageTimes {
+      double seconds[STAGE_COUNT];
+      long samples[STAGE_COUNT];
+  };
+
+  // Adds the time from its construction to its destruction to one stage, and
+  // records it as a profiler zone
+  struct StageTimer {
+      PipelineStage stage;
+      ProfileZone zone;
+
+      StageTimer(PipelineStage stage);
+      ~StageTimer();
+  };
+
+  // Thread that runs the ticks the main thread hands it, while the main thread
+  // draws the ticks before them
+  struct SimulationThread {
+      std::thread thread;
+      std::mutex mutex;
+      std::condition_variable changed;
+      int ticks = 0;
+      InputCommand input = 0;
+      bool busy = false;
+      bool quit = false;
+  };
+
+  // What the draw functions read, copied out of the simulation between ticks
+  struct FrameSnapshot {
+      GameState gameState;
+      Spaceship ship;
+      std::vector<Spark> sparks;
+      BulletStore bullets;
+      CometStore comets;
+      BigCometStore bigComets;
+      PowerUpStore powerUps;
+      ParticleStore particles;
+      float gameTime;
+      int score;
+  };
+
+  // Replay being played back. snapshots[k] is the state before tick
+  // k * REPLAY_SNAPSHOT_INTERVAL, taken the first time playback gets there.
+  struct ReplayPlayback {
+      ReplayHeader header;
+      std::vector<InputCommand> inputs;
+      std::vector<SimulationSnapshot> snapshots;
+      long tick = 0;
   };
 
   // Global variables
   GameState gameState = MENU;
   Spaceship ship;
-  std::vector<Bullet> bullets;
+  BulletStore bullets;
   std::vector<Spark> sparks;
-  std::vector<Star> stars;
-  std::vector<Comet> comets;
-  std::vector<BigComet> bigComets;
-  std::vector<ExplosionParticle> explosionParticles;
-  std::vector<PowerUp> powerUps;
+  StarField stars;
+  CometStore comets;
+  BigCometStore bigComets;
+  ParticleStore explosionParticles;
+  PowerUpStore powerUps;
+
+  // Broad phase, rebuilt once per update before the collision passes
+  SpatialGrid cometGrid;
+  SpatialGrid bigCometGrid;
+  std::vector<int> broadPhaseCandidates;
+  bool verifyBroadPhase = COMETS_VERIFY_BROADPHASE;
+  int broadPhaseMismatches = 0;
+  double gridPassSeconds = 0;       // with verifyBroadPhase, time in each way of running the passes
+  double brutePassSeconds = 0;
+
+  // Integration kernels, chosen by SelectKernels at startup
+  const IntegrationKernels* kernels = nullptr;
+
+  // Threads: the job pool for the per-entity passes, the simulation thread,
+  // and the last published tick, which is what gets drawn
+  JobSystem jobSystem;
+  SimulationThread simulationThread;
+  FrameSnapshot frontFrame;
+  StageTimes stageTimes;
+
+  // Profiler state. Every thread that ends a zone gets a ProfileThread; heap
+  // allocations are counted by the operator new defined with the profiler.
+  Profiler profiler;
+  std::atomic<long> allocationCount{0};
+  thread_local ProfileThread* profileThread = nullptr;
+  const std::chrono::steady_clock::time_point profileEpoch = std::chrono::steady_clock::now();
 
   float gameTime = 0.0f;
   float lastBulletTime = 0.0f;
@@ -191,6 +649,12 @@
   int score = 0;
   bool winTriggered = false;
 
+  // Sounds queued by the simulation since the frontend last played them
+  std::vector<SoundEvent> soundEvents;
+
+  // Replay of the game in progress, if one is being recorded
+  ReplayRecorder recorder;
+
   // Sound related variables
   Music menuMusic;
   Music gameplayMusic;
@@ -204,46 +668,197 @@
   bool musicEnabled = true;
   bool soundEnabled = true;
 
+  // Comet shape cache, filled once by InitShapeCache. Comets keep an index into
+  // these tables instead of a shape of their own.
+  CometShape cometShapes[SHAPE_TEMPLATES];
+  BigCometShape bigCometShapes[SHAPE_TEMPLATES];
+  float morphSin[MORPH_LUT_SIZE];
+  Vector2 trailCircle[TRAIL_SEGMENTS + 1];   // unit circle, first point repeated at the end
+
   // Textures and rendering resources
   Texture2D rockTexture;
-  RenderTexture2D cometTexture;
+  Texture2D particleTexture;
+  Texture2D starTexture;
+
+  // Background layers, baked by BakeBackground and holding premultiplied alpha:
+  // the steady stars over black, and Cronos over transparency. The flickering
+  // stars are drawn between the two.
+  RenderTexture2D starLayer;
+  RenderTexture2D cronosLayer;
+  bool backgroundDirty = true;
 
   // Function prototypes
   void InitStarfield();
   void UpdateStarfield(float dt);
   void DrawStarfield();
   void DrawCronos();
-  void DrawSpaceship();
-  void DrawHealthBar();
+  void BakeBackground();
+  void RefreshBackground();
+  void DrawBackgroundLayer(RenderTexture2D layer);
+  void DrawSpaceship(const Spaceship& ship, float gameTime);
+  void DrawHealthBar(const Spaceship& ship);
   void DrawMusicIcon();
-  void SpawnComet(int tier = MAX_COMET_TIER, float x = -1, float y = -1, float vx = 0, float vy = 0);
-  void SpawnBigComet();
+  EntityHandle SpawnComet(int tier = MAX_COMET_TIER, float x = -1, float y = -1, float vx = 0, float vy = 0);
+  EntityHandle SpawnBigComet();
   Vector2 GetSpawnLocation();
   void CreateSmallExplosion(float x, float y);
   void CreateHugeExplosion(float x, float y);
   void UpdateExplosionParticles(float dt);
+  int EmitParticle();
+  void ExpireParticle(int index);
+  void DrawExplosionParticles(const ParticleStore& p);
+  void IntegrateCometsScalar(float* posX, float* posY, float* velX, float* velY, const float* radius, int count, float dt);
+  void IntegrateParticlesScalar(float* posX, float* posY, const float* velX, const float* velY, float* lifetime, float* size, int count, float dt);
+  void AdvanceScalar(float* value, const float* rate, int count, float dt);
+  #ifdef COMETS_X86_SIMD
+  void IntegrateCometsSSE2(float* posX, float* posY, float* velX, float* velY, const float* radius, int count, float dt);
+  void IntegrateParticlesSSE2(float* posX, float* posY, const float* velX, const float* velY, float* lifetime, float* size, int count, float dt);
+  void AdvanceSSE2(float* value, const float* rate, int count, float dt);
+  void IntegrateCometsAVX2(float* posX, float* posY, float* velX, float* velY, const float* radius, int count, float dt);
+  void IntegrateParticlesAVX2(float* posX, float* posY, const float* velX, const float* velY, float* lifetime, float* size, int count, float dt);
+  void AdvanceAVX2(float* value, const float* rate, int count, float dt);
+  #endif
+  const IntegrationKernels* SelectKernels();
+  int RunKernelBenchmark();
+  void PushTrailPoint(CometTrail& trail, float x, float y);
+  template <typename T> void SwapPop(std::vector<T>& column, int index);
+  int AllocateHandle(HandleTable& handles);
+  void ReleaseHandle(HandleTable& handles, int index);
+  void ClearHandles(HandleTable& handles);
+  EntityHandle GetHandle(const HandleTable& handles, int index);
+  int ResolveHandle(const HandleTable& handles, EntityHandle handle);
+  template <typename Fn> void ForEachColumn(CometStore& store, Fn fn);
+  template <typename Fn> void ForEachColumn(BigCometStore& store, Fn fn);
+  template <typename Fn> void ForEachColumn(BulletStore& store, Fn fn);
+  template <typename Fn> void ForEachColumn(PowerUpStore& store, Fn fn);
+  template <typename Store> int EntityCount(const Store& store);
+  template <typename Store> int AddEntity(Store& store);
+  template <typename Store> void KillEntity(Store& store, int index);
+  template <typename Store> bool IsKilled(const Store& store, int index);
+  template <typename Store> void FlushKills(Store& store);
+  template <typename Store> void ClearEntities(Store& store);
+  void GetGridCellRange(float x, float y, float r, int& x0, int& y0, int& x1, int& y1);
+  template <typename Store> void BuildGrid(SpatialGrid& grid, const Store& items);
+  void QueryGrid(SpatialGrid& grid, float x, float y, float r, int firstItem, int itemCount, std::vector<int>& out);
+  void NoteGridMove(SpatialGrid& grid, int index, float x, float y);
+  template <typename A, typename B, typename Resolve>
+  void ForEachCandidatePair(const A& itemsA, SpatialGrid& gridB, const B& itemsB, bool sameSet, bool useGrid, Resolve resolve);
+  template <typename Pass> void RunCollisionPass(const char* name, Pass pass);
+  template <typename Store> int FindMotionDifference(const Store& a, const Store& b);
+  void ReportBroadPhaseMismatch(const char* pass, int index);
+  bool BulletHitsComet(float x, float y, int index);
+  bool BulletHitsBigComet(float x, float y, int index);
+  int FindBulletTarget(float x, float y);
+  bool FindBulletBigCometHit(float x, float y);
+  bool ResolveCometPair(int i, int j, std::vector<int>& indicesToRemove);
+  bool ResolveBigCometPair(int i, int j);
+  bool ResolveBigCometVsComet(int i, int j);
   void CheckCometCollisions();
   void CheckBigCometCollisions();
+  void RunCometCollisions(bool useGrid);
+  void RunBigCometCollisions(bool useGrid);
+  void ResetSimulation();
   void RestartGame();
-  void DrawNormalComets();
-  void DrawBigComets();
-  void Update(float dt);
-  void Draw();
-  std::vector<CometShapePoint> GenerateCometShape(int segments);
+  void QueueSound(SoundEvent sound);
+  void PlayQueuedSounds();
+  InputCommand ReadInput();
+  InputCommand ScriptedInput(long tick);
+  InputCommand BotInput();
+  uint32_t SimulationChecksum();
+  void SpawnCrowd(int count);
+  int RunHeadless(int argc, char** argv);
+  void StartNewGame();
+  bool StartRecording(const char* path, uint32_t seed, float dt);
+  void RecordTick(InputCommand input);
+  void StopRecording();
+  bool LoadReplay(const char* path, ReplayHeader& header, std::vector<InputCommand>& inputs);
+  void CaptureSnapshot(SimulationSnapshot& snapshot);
+  void RestoreSnapshot(const SimulationSnapshot& snapshot);
+  void BeginPlayback(ReplayPlayback& playback);
+  void AdvancePlayback(ReplayPlayback& playback, long targetTick);
+  void SeekPlayback(ReplayPlayback& playback, long targetTick);
+  void DrawPlaybackOverlay(const ReplayPlayback& playback, int ticksPerFrame, bool paused);
+  int RunReplayViewer(const char* path);
+  void UnloadResources();
+  void StartJobSystem(int workerCount);
+  void StopJobSystem();
+  void WorkerLoop(int index);
+  bool PushJob(int index, const Job& job);
+  bool RunOneJob(int home);
+  void WakeWorkers();
+  template <typename Body> void ParallelFor(int count, int grain, Body body);
+  void PrintStageTimes(long frames);
+  int64_t ProfileNow();
+  ProfileThread* CurrentProfileThread();
+  void NameProfileThread(const char* name);
+  void RecordProfileEvent(const char* name, int64_t start, int64_t end);
+  void AddZoneTime(const char* name, double ms);
+  void ProfileFrameMark();
+  bool DumpProfileTrace(const char* path, int frames);
+  void HandleProfilerKeys();
+  void DrawProfilerHud(const FrameSnapshot& frame);
+  void StartSimulationThread();
+  void StopSimulationThread();
+  void SimulationThreadLoop();
+  void RunTicksAsync(int ticks, InputCommand input);
+  void WaitForTicks();
+  void CopyParticles(ParticleStore& dst, const ParticleStore& src);
+  void PublishFrame(FrameSnapshot& frame);
+  void DrawNormalComets(const CometStore& comets, float gameTime);
+  void DrawBigComets(const BigCometStore& bigComets, float gameTime);
+  void Update(float dt, InputCommand input);
+  void Draw(const FrameSnapshot& frame);
+  void GenerateCometShape(CometShapePoint* points, int segments, std::mt19937& engine);
+  void InitShapeCache();
+  float LookupSin(float radians);
+  void EmitCometPolygon(float cx, float cy, const CometShapePoint* shape, const float* dist, int segments, Color fill,
+                        Color outline, float outlineWidth);
   std::string GetQuadrant(float x, float y);
   bool IsInSameQuadrant(float x1, float y1, float x2, float y2);
-  PowerUp SpawnPowerUp();
+  EntityHandle SpawnPowerUp();
   void ToggleMusic();
   void ToggleAllSounds();
   void StartMenuMusic();
   void StartGameplayMusic();
 
-  // Main function
+  // Build with -DCOMETS_SIMD_BENCH to get the kernel microbenchmark instead of the game
+  #if defined(COMETS_SIMD_BENCH)
   int main() {
+      return RunKernelBenchmark();
+  }
+  #elif defined(COMETS_HEADLESS)
+  int main(int argc, char** argv) {
+      return RunHeadless(argc, argv);
+  }
+  #else
+  // Main function. Options: --workers N sizes the job pool (none by default,
+  // since no pass in a normal game pays for waking one); --replay FILE plays
+  // back a recording instead of the game. F3 shows the profiler HUD and F4
+  // writes a trace of the last frames.
+  int main(int argc, char** argv) {
+      int workerCount = 0;
+      const char* replayPath = nullptr;
+      for (int i = 1; i + 1 < argc; i += 2) {
+          if (!strcmp(argv[i], "--workers")) workerCount = atoi(argv[i + 1]);
+          else if (!strcmp(argv[i], "--replay")) replayPath = argv[i + 1];
+      }
+
       // Initialize window
       InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, GAME_TITLE);
       SetTargetFPS(60);
 
+      // Pick the widest integration kernels this CPU supports
+      kernels = SelectKernels();
+      TraceLog(LOG_INFO, "Integration kernels: %s", kernels->name);
+
+      // Build the comet shape templates and lookup tables
+      InitShapeCache();
+
+      // Start the job pool for the per-entity passes
+      NameProfileThread("main");
+      StartJobSystem(workerCount);
+      TraceLog(LOG_INFO, "Job workers: %d", workerCount);
+
       // Initialize audio device
       InitAudioDevice();
 
@@ -273,25 +888,59 @@
       rockTexture = LoadTextureFromImage(rockImg);
       UnloadImage(rockImg);
 
+      // Disc sprite for the batched particle draw, tinted per particle
+      Image particleImg = GenImageColor(64, 64, BLANK);
+      ImageDrawCircle(&particleImg, 32, 32, 31, WHITE);
+      particleTexture = LoadTextureFromImage(particleImg);
+      UnloadImage(particleImg);
+      SetTextureFilter(particleTexture, TEXTURE_FILTER_BILINEAR);
+
+      // Soft disc sprite for the flickering stars, white fading to clear
+      Image starImg = GenImageGradientRadial(32, 32, 0.0f, WHITE, (Color){255, 255, 255, 0});
+      starTexture = LoadTextureFromImage(starImg);
+      UnloadImage(starImg);
+      SetTextureFilter(starTexture, TEXTURE_FILTER_BILINEAR);
+
+      // Render targets for the baked background layers
+      starLayer = LoadRenderTexture(SCREEN_WIDTH, SCREEN_HEIGHT);
+      cronosLayer = LoadRenderTexture(SCREEN_WIDTH, SCREEN_HEIGHT);
+
       // Initialize game resources
       InitStarfield();
 
-      // Initialize player ship
-      ship.position = (Vector2){ SCREEN_WIDTH / 2.0f, SCREEN_HEIGHT / 2.0f };
-      ship.velocity = (Vector2){ 0, 0 };
-      ship.angle = 0;
-      ship.size = SHIP_SIZE;
-      ship.hitPoints = 5;
-      ship.hitFlashTimer = 0;
+      // Initialize player ship and spawn the initial comet
+      ResetSimulation();
 
-      // Spawn initial comet
-      SpawnComet();
+      if (replayPath) {
+          const int result = RunReplayViewer(replayPath);
+          UnloadResources();
+          StopJobSystem();
+          return result;
+      }
 
       // Start menu music
       StartMenuMusic();
 
+      // Wall-clock time not yet simulated, run off in FIXED_DT ticks
+      float tickAccumulator = 0.0f;
+      long frames = 0;
+
+      // Ticks run on the simulation thread while the ones before them are drawn
+      StartSimulationThread();
+      PublishFrame(frontFrame);
+
       // Main game loop
       while (!WindowShouldClose()) {
+          // Collect the ticks started last frame and publish them for drawing.
+          // The simulation state is this thread's again until the next ticks start.
+          {
+              StageTimer timer(STAGE_WAIT);
+              WaitForTicks();
+          }
+          PublishFrame(frontFrame);
+          if (gameState == GAMEOVER || gameState == WIN) StopRecording();
+          PlayQueuedSounds();
+
           // Update music streams
           if (musicEnabled) {
               if (gameState == MENU || gameState == SETTINGS) {
@@ -315,11 +964,7 @@
 
           if (gameState == MENU) {
               if (IsKeyPressed(KEY_ENTER)) {
-                  gameState = PLAYING;
-                  score = 0;
-                  gameTime = 0;
-                  winTriggered = false;
-                  StartGameplayMusic();
+                  StartNewGame();
               } else if (IsKeyPressed(KEY_S)) {
                   gameState = SETTINGS;
               }
@@ -336,18 +981,53 @@
               StartMenuMusic();
           }
 
-          // Update game
-          Update(dt);
+          // Start this frame's fixed ticks on the simulation thread
+          tickAccumulator += dt;
+          int ticksDue = 0;
+          while (tickAccumulator >= FIXED_DT && ticksDue < MAX_TICKS_PER_FRAME) {
+              tickAccumulator -= FIXED_DT;
+              ticksDue++;
+          }
+          if (ticksDue == MAX_TICKS_PER_FRAME) tickAccumulator = 0.0f;
+          RunTicksAsync(ticksDue, ReadInput());
 
-          // Draw everything
+          // Draw the published tick meanwhile
+          UpdateStarfield(dt);
+          RefreshBackground();
           BeginDrawing();
           ClearBackground(BLACK);
-          Draw();
-          EndDrawing();
+          {
+              StageTimer timer(STAGE_DRAW);
+              Draw(frontFrame);
+              DrawProfilerHud(frontFrame);
+          }
+          {
+              PROFILE_ZONE("end drawing");
+              EndDrawing();
+          }
+          frames++;
+
+          ProfileFrameMark();
+          HandleProfilerKeys();
       }
 
-      // Unload resources
+      WaitForTicks();
+      StopSimulationThread();
+      StopRecording();
+      PrintStageTimes(frames);
+      UnloadResources();
+      StopJobSystem();
+
+      return 0;
+  }
+
+  // Unload textures and sounds and close the audio device and window
+  void UnloadResources() {
       UnloadTexture(rockTexture);
+      UnloadTexture(particleTexture);
+      UnloadTexture(starTexture);
+      UnloadRenderTexture(starLayer);
+      UnloadRenderTexture(cronosLayer);
 
       // Unload sounds
       UnloadMusicStream(menuMusic);
@@ -361,57 +1041,84 @@
 
       CloseAudioDevice();
       CloseWindow();
-
-      return 0;
   }
+  #endif
 
   // Initialize stars
   void InitStarfield() {
-      stars.clear();
-      stars.resize(NUM_STARS);
+      stars.x.resize(NUM_STARS);
+      stars.y.resize(NUM_STARS);
+      stars.baseSize.resize(NUM_STARS);
+      stars.sizeVariation.resize(NUM_STARS);
+      stars.sizeSpeed.resize(NUM_STARS);
+      stars.sizeTime.resize(NUM_STARS);
+      stars.flicker.resize(NUM_STARS);
 
       for (int i = 0; i < NUM_STARS; i++) {
-          Star& star = stars[i];
-          star.x = RandomRange(0, SCREEN_WIDTH);
-          star.y = RandomRange(0, SCREEN_HEIGHT);
-          star.baseSize = RandomRange(0.5f, 2.5f);
-          star.flicker = RandomRange(0.0f, 1.0f) < 0.7f;
-          star.sizeVariation = star.flicker ? RandomRange(0.2f, 1.2f) : 0.0f;
-          star.sizeSpeed = star.flicker ? RandomRange(0.2f, 0.7f) : 0.0f;
-          star.sizeTime = star.flicker ? RandomRange(0.0f, 2.0f * PI) : 0.0f;
+          stars.x[i] = RandomRange(0, SCREEN_WIDTH, visualRng);
+          stars.y[i] = RandomRange(0, SCREEN_HEIGHT, visualRng);
+          stars.baseSize[i] = RandomRange(0.5f, 2.5f, visualRng);
+          stars.flicker[i] = RandomRange(0.0f, 1.0f, visualRng) < 0.7f;
+          stars.sizeVariation[i] = stars.flicker[i] ? RandomRange(0.2f, 1.2f, visualRng) : 0.0f;
+          stars.sizeSpeed[i] = stars.flicker[i] ? RandomRange(0.2f, 0.7f, visualRng) : 0.0f;
+          stars.sizeTime[i] = stars.flicker[i] ? RandomRange(0.0f, 2.0f * PI, visualRng) : 0.0f;
       }
+
+      // The steady stars are baked into the background
+      backgroundDirty = true;
   }
 
   // Update starfield
   void UpdateStarfield(float dt) {
-      for (auto& star : stars) {
-          if (star.flicker) {
-              star.sizeTime += dt * star.sizeSpeed;
-          }
-      }
+      StageTimer timer(STAGE_STARFIELD);
+      ParallelFor(NUM_STARS, STAR_GRAIN, [dt](int begin, int end) {
+          kernels->advance(stars.sizeTime.data() + begin, stars.sizeSpeed.data() + begin, end - begin, dt);
+      });
   }
 
-  // Draw starfield
+  // Draw starfield: the baked layer of steady stars, then every flickering star
+  // as a sprite in one batch of quads
   void DrawStarfield() {
-      for (const auto& star : stars) {
-          float currentSize = star.baseSize;
-          if (star.flicker) {
-              currentSize += star.sizeVariation * sin(star.sizeTime);
-              if (currentSize < 0) currentSize = 0;
+      PROFILE_ZONE("draw starfield");
+
+      DrawBackgroundLayer(starLayer);
+
+      for (int start = 0; start < NUM_STARS; start += STAR_BATCH) {
+          const int end = std::min(NUM_STARS, start + STAR_BATCH);
+
+          // Flush first if this chunk would overflow the current batch
+          rlCheckRenderBatchLimit(4 * (end - start));
+
+          rlSetTexture(starTexture.id);
+          rlBegin(RL_QUADS);
+          rlColor4ub(255, 255, 255, 255);
+          for (int i = start; i < end; i++) {
+              if (!stars.flicker[i]) continue;
+
+              float currentSize = stars.baseSize[i] + stars.sizeVariation[i] * sin(stars.sizeTime[i]);
+              if (currentSize <= 0) continue;
+
+              const float x = (int)stars.x[i];
+              const float y = (int)stars.y[i];
+              rlTexCoord2f(0.0f, 0.0f);
+              rlVertex2f(x - currentSize, y - currentSize);
+              rlTexCoord2f(0.0f, 1.0f);
+              rlVertex2f(x - currentSize, y + currentSize);
+              rlTexCoord2f(1.0f, 1.0f);
+              rlVertex2f(x + currentSize, y + currentSize);
+              rlTexCoord2f(1.0f, 0.0f);
+              rlVertex2f(x + currentSize, y - currentSize);
           }
-
-          // Draw star as a white circle with gradient
-          DrawCircleGradient(
-              (int)star.x, (int)star.y,
-              currentSize,
-              ColorAlpha(WHITE, 1.0f),
-              ColorAlpha(WHITE, 0.0f)
-          );
+          rlEnd();
       }
+
+      rlSetTexture(0);
   }
 
   // Draw Cronos planet
   void DrawCronos() {
+      PROFILE_ZONE("cronos");
+
       // Planet position & size
       float x = SCREEN_WIDTH * 0.75f;
       float y = SCREEN_HEIGHT * 0.5f;
@@ -423,7 +1130,6 @@
       float ringFlatten = 0.45f;
 
       // Draw the back half of the ring
-      BeginBlendMode(BLEND_ALPHA);
       DrawEllipse(
           x, y,
           ringOuter, ringOuter * ringFlatten,
@@ -443,11 +1149,60 @@
           1.5f,
           ColorAlpha(WHITE, 0.3f)
       );
+  }
+
+  // Redraw the static background layers. Color blends as usual while alpha
+  // accumulates as ONE, ONE_MINUS_SRC_ALPHA, so each layer ends up holding
+  // premultiplied alpha and composites exactly with BLEND_ALPHA_PREMULTIPLY.
+  void BakeBackground() {
+      PROFILE_ZONE("bake background");
+
+      rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+
+      BeginTextureMode(starLayer);
+      ClearBackground(BLACK);
+      BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+      for (int i = 0; i < NUM_STARS; i++) {
+          if (stars.flicker[i]) continue;
+
+          // Draw star as a white circle with gradient
+          DrawCircleGradient(
+              (int)stars.x[i], (int)stars.y[i],
+              stars.baseSize[i],
+              ColorAlpha(WHITE, 1.0f),
+              ColorAlpha(WHITE, 0.0f)
+          );
+      }
+      EndBlendMode();
+      EndTextureMode();
+
+      BeginTextureMode(cronosLayer);
+      ClearBackground(BLANK);
+      BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+      DrawCronos();
+      EndBlendMode();
+      EndTextureMode();
+
+      backgroundDirty = false;
+  }
+
+  // Rebake the background when it is stale. Call outside BeginDrawing.
+  void RefreshBackground() {
+      if (IsWindowResized()) backgroundDirty = true;
+      if (backgroundDirty) BakeBackground();
+  }
+
+  // Draw a baked background layer over the whole screen. Render textures come
+  // out upside down, hence the negative source height.
+  void DrawBackgroundLayer(RenderTexture2D layer) {
+      BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+      DrawTextureRec(layer.texture, (Rectangle){ 0, 0, (float)layer.texture.width, -(float)layer.texture.height },
+                     (Vector2){ 0, 0 }, WHITE);
       EndBlendMode();
   }
 
   // Draw the player's spaceship
-  void DrawSpaceship() {
+  void DrawSpaceship(const Spaceship& ship, float gameTime) {
       // Save original position and angle for transform
       Vector2 pos = ship.position;
       float angle = ship.angle;
@@ -495,7 +1250,7 @@
       DrawPolyLines(bottomGun, 4, true, 2.0f, LIGHTGRAY);
 
       // Flame (if moving forward)
-      if (IsKeyDown(KEY_UP)) {
+      if (ship.thrusting) {
           float flameLength = ship.size * 0.8f;
           float flameWidth = ship.size * 0.3f;
 
@@ -521,7 +1276,7 @@
   }
 
   // Draw health bar
-  void DrawHealthBar() {
+  void DrawHealthBar(const Spaceship& ship) {
       const float barWidth = 100.0f;
       const float barHeight = 15.0f;
       const float margin = 20.0f;
@@ -565,73 +1320,141 @@
       }
   }
 
-  // Generate a shape for a comet
-  std::vector<CometShapePoint> GenerateCometShape(int segments) {
-      std::vector<CometShapePoint> shape;
+  // Draw the profiler HUD: mean frame time, allocations and zone times over the
+  // last PROFILE_HUD_FRAMES frames, and the drawn tick's entity counts
+  void DrawProfilerHud(const FrameSnapshot& frame) {
+      if (!profiler.hudVisible) return;
+
+      const int x = 20;
+      const int lineHeight = 18;
+      int y = 60;
+      DrawRectangle(x - 6, y - 6, 340, (3 + profiler.zoneCount) * lineHeight + 12, ColorAlpha(BLACK, 0.7f));
+
+      char text[96];
+      snprintf(text, sizeof(text), "Frame %.2f ms, %d FPS, %.1f allocs/frame", profiler.frameMs, GetFPS(),
+               profiler.allocationsPerFrame);
+      DrawText(text, x, y, 16, GREEN);
+      y += lineHeight;
+
+      snprintf(text, sizeof(text), "Comets %d, big %d, bullets %d, power-ups %d", EntityCount(frame.comets),
+               EntityCount(frame.bigComets), EntityCount(frame.bullets), EntityCount(frame.powerUps));
+      DrawText(text, x, y, 16, WHITE);
+      y += lineHeight;
+
+      snprintf(text, sizeof(text), "Particles %d, sparks %d, workers %d", frame.particles.count, (int)frame.sparks.size(),
+               jobSystem.queueCount);
+      DrawText(text, x, y, 16, WHITE);
+      y += lineHeight;
+
+      for (int i = 0; i < profiler.zoneCount; i++) {
+          const ProfileZoneStats& zone = profiler.zones[i];
+          DrawText(zone.name, x, y, 16, LIGHTGRAY);
+          snprintf(text, sizeof(text), "%7.3f ms  %5.1f/frame", zone.ms, zone.calls);
+          DrawText(text, x + 150, y, 16, LIGHTGRAY);
+          y += lineHeight;
+      }
+  }
 
+  // Generate a shape for a comet
+  void GenerateCometShape(CometShapePoint* points, int segments, std::mt19937& engine) {
       for (int i = 0; i < segments; i++) {
-          CometShapePoint point;
+          CometShapePoint& point = points[i];
           point.angle = i * 2.0f * PI / segments;
-          point.factor = 1.0f + (RandomRange(0.0f, 1.0f) * 0.3f - 0.15f);
-          point.frequency = (RandomRange(1.0f, 3.0f) * 2.0f);
-          point.phase = RandomRange(0.0f, 2.0f * PI);
-          shape.push_back(point);
+          point.cosAngle = cosf(point.angle);
+          point.sinAngle = sinf(point.angle);
+          point.factor = 1.0f + (RandomRange(0.0f, 1.0f, engine) * 0.3f - 0.15f);
+          point.frequency = (RandomRange(1.0f, 3.0f, engine) * 2.0f);
+          point.phase = RandomRange(0.0f, 2.0f * PI, engine);
+      }
+  }
+
+  // Fill the shape templates and the lookup tables the comet draw uses. The
+  // templates come from their own fixed-seed engine, so they are identical in
+  // every run and building them draws nothing from the simulation's.
+  void InitShapeCache() {
+      std::mt19937 shapeRng(SHAPE_SEED);
+      for (int s = 0; s < SHAPE_TEMPLATES; s++) {
+          GenerateCometShape(cometShapes[s].points, COMET_SEGMENTS, shapeRng);
+
+          // Use more segments for a smoother, rounder shape
+          CometShapePoint* shape = bigCometShapes[s].points;
+          GenerateCometShape(shape, BIG_COMET_SEGMENTS, shapeRng);
+
+          // Make big comets much more round with minimal variation
+          for (int k = 0; k < BIG_COMET_SEGMENTS; k++) {
+              CometShapePoint& point = shape[k];
+              // Minimal variation for near-perfect roundness
+              point.factor = 1.0f + (point.factor - 1.0f) * 0.05f;
+              // Greatly reduce frequency for slower rotation
+              point.frequency = point.frequency * 0.3f;
+          }
+      }
+
+      for (int k = 0; k < MORPH_LUT_SIZE; k++) {
+          morphSin[k] = sinf(k * 2.0f * PI / MORPH_LUT_SIZE);
+      }
+
+      for (int k = 0; k <= TRAIL_SEGMENTS; k++) {
+          const float angle = (k % TRAIL_SEGMENTS) * 2.0f * PI / TRAIL_SEGMENTS;
+          trailCircle[k] = (Vector2){ cosf(angle), sinf(angle) };
       }
+  }
 
-      return shape;
+  // sin from the morph lookup table, to the nearest of its samples
+  float LookupSin(float radians) {
+      const int index = (int)floorf(radians * (MORPH_LUT_SIZE / (2.0f * PI)) + 0.5f);
+      return morphSin[index & (MORPH_LUT_SIZE - 1)];
   }
 
   // Spawn a comet
-  void SpawnComet(int tier, float x, float y, float vx, float vy) {
-      Comet comet;
+  EntityHandle SpawnComet(int tier, float x, float y, float vx, float vy) {
+      const int i = AddEntity(comets);
 
       // Position
       if (x < 0 || y < 0) {
           Vector2 loc = GetSpawnLocation();
-          comet.position.x = loc.x;
-          comet.position.y = loc.y;
+          comets.posX[i] = loc.x;
+          comets.posY[i] = loc.y;
       } else {
-          comet.position.x = x;
-          comet.position.y = y;
+          comets.posX[i] = x;
+          comets.posY[i] = y;
       }
 
       // Velocity
       if (vx == 0 && vy == 0) {
           float angle = RandomRange(0.0f, 2.0f * PI);
           float speed = RandomRange(COMET_SPEED_MIN, COMET_SPEED_MAX);
-          comet.velocity.x = cosf(angle) * speed;
-          comet.velocity.y = sinf(angle) * speed;
+          comets.velX[i] = cosf(angle) * speed;
+          comets.velY[i] = sinf(angle) * speed;
       } else {
-          comet.velocity.x = vx;
-          comet.velocity.y = vy;
+          comets.velX[i] = vx;
+          comets.velY[i] = vy;
       }
 
       // Size and properties
-      comet.radius = BASE_COMET_RADIUS * powf(0.6f, MAX_COMET_TIER - tier);
+      comets.radius[i] = BASE_COMET_RADIUS * powf(0.6f, MAX_COMET_TIER - tier);
 
       // Health based on tier
-      if (tier == 3) comet.hitPoints = 5;
-      else if (tier == 2) comet.hitPoints = 4;
-      else comet.hitPoints = 3;
-
-      comet.tier = tier;
-      comet.color = DARKGRAY;
-      comet.hitEffectTimer = 0;
-      comet.slowEffectTimer = 0;
-      comet.indestructableTimer = 0;
-      comet.oldVX = comet.velocity.x;
-      comet.oldVY = comet.velocity.y;
-      comet.trailTimer = 0;
-      comet.shape = GenerateCometShape(12); // More segments for rounder comets
-      comet.morph = true;
-      comet.rotationSpeed = RandomRange(1.0f, 3.0f);
-
-      comets.push_back(comet);
+      if (tier == 3) comets.hitPoints[i] = 5;
+      else if (tier == 2) comets.hitPoints[i] = 4;
+      else comets.hitPoints[i] = 3;
+
+      comets.tier[i] = tier;
+      comets.color[i] = DARKGRAY;
+      comets.hitEffectTimer[i] = 0;
+      comets.slowEffectTimer[i] = 0;
+      comets.indestructableTimer[i] = 0;
+      comets.trailTimer[i] = 0;
+      comets.trail[i].count = 0;
+      comets.shapeId[i] = RandomInt(0, SHAPE_TEMPLATES - 1);
+      comets.morph[i] = true;
+      comets.rotationSpeed[i] = RandomRange(1.0f, 3.0f);
+
+      return GetHandle(comets.handles, i);
   }
 
   // Spawn a big comet
-  void SpawnBigComet() {
-      BigComet bigComet;
+  EntityHandle SpawnBigComet() {
       float x, y, angle;
 
       // Choose starting position that will cross closer to center screen
@@ -662,30 +1485,19 @@
       // Slow down big comets for longer screen time
       float speed = RandomRange(BIG_COMET_SPEED_MIN * 0.7f, BIG_COMET_SPEED_MAX * 0.7f);
 
-      bigComet.position.x = x;
-      bigComet.position.y = y;
-      bigComet.velocity.x = cosf(angle) * speed;
-      bigComet.velocity.y = sinf(angle) * speed;
-      bigComet.radius = BASE_COMET_RADIUS * BIG_COMET_SCALE;
-      bigComet.color = (Color){205, 127, 50, 255}; // Bronze color
-
-      // Use more segments for a smoother, rounder shape
-      std::vector<CometShapePoint> shape = GenerateCometShape(18);
-
-      // Make big comets much more round with minimal variation
-      for (auto& point : shape) {
-          // Minimal variation for near-perfect roundness
-          point.factor = 1.0f + (point.factor - 1.0f) * 0.05f;
-          // Greatly reduce frequency for slower rotation
-          point.frequency = point.frequency * 0.3f;
-      }
+      const int i = AddEntity(bigComets);
+      bigComets.posX[i] = x;
+      bigComets.posY[i] = y;
+      bigComets.velX[i] = cosf(angle) * speed;
+      bigComets.velY[i] = sinf(angle) * speed;
+      bigComets.radius[i] = BASE_COMET_RADIUS * BIG_COMET_SCALE;
+      bigComets.color[i] = (Color){205, 127, 50, 255}; // Bronze color
 
-      bigComet.shape = shape;
-      bigComet.trailTimer = 0;
-      bigComet.morph = true;
-      bigComet.rotationSpeed = RandomRange(0.3f, 0.5f);
+      bigComets.shapeId[i] = RandomInt(0, SHAPE_TEMPLATES - 1);
+      bigComets.morph[i] = true;
+      bigComets.rotationSpeed[i] = RandomRange(0.3f, 0.5f);
 
-      bigComets.push_back(bigComet);
+      return GetHandle(bigComets.handles, i);
   }
 
   // Get a spawn location for comets and power-ups
@@ -726,374 +1538,2304 @@
 
   // Create a small explosion
   void CreateSmallExplosion(float x, float y) {
-      if (soundEnabled) {
-          PlaySound(explosionSound);
-      }
+      QueueSound(SOUND_EXPLOSION);
 
       const int count = 10;
       for (int i = 0; i < count; i++) {
           float angle = RandomRange(0.0f, 2.0f * PI);
           float speed = RandomRange(50.0f, 150.0f);
 
-          ExplosionParticle particle;
-          particle.position = (Vector2){x, y};
-          particle.velocity = (Vector2){cosf(angle) * speed, sinf(angle) * speed};
-          particle.lifetime = RandomRange(0.3f, 0.7f);
-          particle.size = RandomRange(2.0f, 4.0f);
-          particle.color = ORANGE;
-
-          explosionParticles.push_back(particle);
+          const int p = EmitParticle();
+          explosionParticles.posX[p] = x;
+          explosionParticles.posY[p] = y;
+          explosionParticles.velX[p] = cosf(angle) * speed;
+          explosionParticles.velY[p] = sinf(angle) * speed;
+          explosionParticles.lifetime[p] = RandomRange(0.3f, 0.7f);
+          explosionParticles.size[p] = RandomRange(2.0f, 4.0f);
+          explosionParticles.color[p] = ORANGE;
       }
   }
 
   // Create a huge explosion
   void CreateHugeExplosion(float x, float y) {
-      if (soundEnabled) {
-          PlaySound(explosionSound);
-      }
+      QueueSound(SOUND_EXPLOSION);
 
       const int count = 50;
       for (int i = 0; i < count; i++) {
           float angle = RandomRange(0.0f, 2.0f * PI);
           float speed = RandomRange(100.0f, 300.0f);
 
-          ExplosionParticle particle;
-          particle.position = (Vector2){x, y};
-          particle.velocity = (Vector2){cosf(angle) * speed, sinf(angle) * speed};
-          particle.lifetime = RandomRange(0.8f, 1.5f);
-          particle.size = RandomRange(5.0f, 10.0f);
-          particle.color = ORANGE;
-
-          explosionParticles.push_back(particle);
+          const int p = EmitParticle();
+          explosionParticles.posX[p] = x;
+          explosionParticles.posY[p] = y;
+          explosionParticles.velX[p] = cosf(angle) * speed;
+          explosionParticles.velY[p] = sinf(angle) * speed;
+          explosionParticles.lifetime[p] = RandomRange(0.8f, 1.5f);
+          explosionParticles.size[p] = RandomRange(5.0f, 10.0f);
+          explosionParticles.color[p] = ORANGE;
       }
   }
 
   // Update explosion particles
   void UpdateExplosionParticles(float dt) {
-      for (int i = explosionParticles.size() - 1; i >= 0; i--) {
-          ExplosionParticle& p = explosionParticles[i];
-
-          p.position.x += p.velocity.x * dt;
-          p.position.y += p.velocity.y * dt;
-          p.lifetime -= dt;
-          p.size *= 0.98f;
-
-          if (p.lifetime <= 0) {
-              explosionParticles.erase(explosionParticles.begin() + i);
+      ParticleStore& p = explosionParticles;
+      ParallelFor(p.count, PARTICLE_GRAIN, [&p, dt](int begin, int end) {
+          kernels->integrateParticles(p.posX + begin, p.posY + begin, p.velX + begin, p.velY + begin, p.lifetime + begin,
+                                      p.size + begin, end - begin, dt);
+      });
+
+      // Expire dead particles, rechecking whichever one moves into the slot
+      for (int i = 0; i < p.count; ) {
+          if (p.lifetime[i] <= 0) {
+              ExpireParticle(i);
+          } else {
+              i++;
           }
       }
   }
 
-  // Check for collisions between comets
-  void CheckCometCollisions() {
-      std::vector<int> indicesToRemove;
+  // Claim a particle slot. Once the pool is full, live slots are recycled in turn.
+  int EmitParticle() {
+      ParticleStore& p = explosionParticles;
+      if (p.count < MAX_PARTICLES) return p.count++;
 
-      for (size_t i = 0; i < comets.size(); i++) {
-          for (size_t j = i + 1; j < comets.size(); j++) {
-              Comet& c1 = comets[i];
-              Comet& c2 = comets[j];
-
-              float dx = c2.position.x - c1.position.x;
-              float dy = c2.position.y - c1.position.y;
-              float dist = sqrtf(dx*dx + dy*dy);
-              float minDist = c1.radius + c2.radius;
-
-              // Colliding
-              if (dist < minDist && dist > 0) {
-                  // If either is < MAX tier, we remove it
-                  if (c1.tier < MAX_COMET_TIER) {
-                      indicesToRemove.push_back(i);
-                      CreateSmallExplosion(c1.position.x, c1.position.y);
-                      score += 5;
-                  }
+      const int index = p.recycle;
+      p.recycle = (p.recycle + 1) % MAX_PARTICLES;
+      return index;
+  }
 
-                  if (c2.tier < MAX_COMET_TIER) {
-                      indicesToRemove.push_back(j);
-                      CreateSmallExplosion(c2.position.x, c2.position.y);
-                      score += 5;
-                  }
+  // Free a particle slot by moving the last live particle into it
+  void ExpireParticle(int index) {
+      ParticleStore& p = explosionParticles;
+      const int last = --p.count;
+
+      p.posX[index] = p.posX[last];
+      p.posY[index] = p.posY[last];
+      p.velX[index] = p.velX[last];
+      p.velY[index] = p.velY[last];
+      p.lifetime[index] = p.lifetime[last];
+      p.size[index] = p.size[last];
+      p.color[index] = p.color[last];
+  }
 
-                  // If both are MAX tier, bounce
-                  if (c1.tier == MAX_COMET_TIER && c2.tier == MAX_COMET_TIER) {
-                      float nx = dx / dist;
-                      float ny = dy / dist;
-                      float dvx = c1.velocity.x - c2.velocity.x;
-                      float dvy = c1.velocity.y - c2.velocity.y;
-                      float dot = dvx * nx + dvy * ny;
-
-                      if (dot <= 0) {
-                          float impulse = dot;
-                          c1.velocity.x -= impulse * nx;
-                          c1.velocity.y -= impulse * ny;
-                          c2.velocity.x += impulse * nx;
-                          c2.velocity.y += impulse * ny;
-
-                          float overlap = minDist - dist;
-                          c1.position.x -= nx * overlap / 2.0f;
-                          c1.position.y -= ny * overlap / 2.0f;
-                          c2.position.x += nx * overlap / 2.0f;
-                          c2.position.y += ny * overlap / 2.0f;
-                      }
-                  }
-              }
+  // Draw every particle as a tinted disc sprite, in as few rlgl batches as
+  // the render buffer allows
+  void DrawExplosionParticles(const ParticleStore& p) {
+      PROFILE_ZONE("draw particles");
+
+      for (int start = 0; start < p.count; start += PARTICLE_BATCH) {
+          const int end = std::min(p.count, start + PARTICLE_BATCH);
+
+          // Flush first if this chunk would overflow the current batch
+          rlCheckRenderBatchLimit(4 * (end - start));
+
+          rlSetTexture(particleTexture.id);
+          rlBegin(RL_QUADS);
+          for (int i = start; i < end; i++) {
+              const float x0 = p.posX[i] - p.size[i];
+              const float y0 = p.posY[i] - p.size[i];
+              const float x1 = p.posX[i] + p.size[i];
+              const float y1 = p.posY[i] + p.size[i];
+
+              rlColor4ub(p.color[i].r, p.color[i].g, p.color[i].b, p.color[i].a);
+              rlTexCoord2f(0.0f, 0.0f);
+              rlVertex2f(x0, y0);
+              rlTexCoord2f(0.0f, 1.0f);
+              rlVertex2f(x0, y1);
+              rlTexCoord2f(1.0f, 1.0f);
+              rlVertex2f(x1, y1);
+              rlTexCoord2f(1.0f, 0.0f);
+              rlVertex2f(x1, y0);
           }
+          rlEnd();
       }
 
-      // Remove comets that were marked (in reverse order to avoid invalidating indices)
-      std::sort(indicesToRemove.begin(), indicesToRemove.end(), std::greater<int>());
-      for (auto index : indicesToRemove) {
-          if (index >= 0 && index < (int)comets.size()) {
-              comets.erase(comets.begin() + index);
-          }
-      }
+      rlSetTexture(0);
   }
 
-  // Check for collisions between big comets
-  void CheckBigCometCollisions() {
-      // Big Comets vs. Big Comets
-      for (size_t i = 0; i < bigComets.size(); i++) {
-          for (size_t j = i + 1; j < bigComets.size(); j++) {
-              BigComet& bc1 = bigComets[i];
-              BigComet& bc2 = bigComets[j];
-
-              float dx = bc2.position.x - bc1.position.x;
-              float dy = bc2.position.y - bc1.position.y;
-              float dist = sqrtf(dx*dx + dy*dy);
-              float minDist = bc1.radius + bc2.radius;
-
-              if (dist < minDist && dist > 0) {
-                  float nx = dx / dist;
-                  float ny = dy / dist;
-                  float overlap = minDist - dist;
-
-                  // Bounce them apart equally
-                  bc1.position.x -= nx * (overlap / 2.0f);
-                  bc1.position.y -= ny * (overlap / 2.0f);
-                  bc2.position.x += nx * (overlap / 2.0f);
-                  bc2.position.y += ny * (overlap / 2.0f);
-
-                  // Adjust velocities (to simulate a bounce)
-                  float impulse = (bc1.velocity.x - bc2.velocity.x) * nx + (bc1.velocity.y - bc2.velocity.y) * ny;
-                  if (impulse < 0) {
-                      bc1.velocity.x -= impulse * nx;
-                      bc1.velocity.y -= impulse * ny;
-                      bc2.velocity.x += impulse * nx;
-                      bc2.velocity.y += impulse * ny;
-                  }
-              }
+  // Integrate comets: move, apply friction, hold the minimum speed and bounce off
+  // the screen edges. The edge checks pick values instead of branching, and the
+  // speed check compares squared speeds so only the clamp factor needs a sqrt.
+  void IntegrateCometsScalar(float* posX, float* posY, float* velX, float* velY, const float* radius, int count, float dt) {
+      const float minSpeedSq = COMET_MIN_SPEED * COMET_MIN_SPEED;
+
+      for (int i = 0; i < count; i++) {
+          float x = posX[i] + velX[i] * dt;
+          float y = posY[i] + velY[i] * dt;
+          float vx = velX[i] * COMET_FRICTION;
+          float vy = velY[i] * COMET_FRICTION;
+
+          // Never drop below COMET_MIN_SPEED
+          const float speedSq = vx * vx + vy * vy;
+          if (speedSq < minSpeedSq && speedSq > 0) {
+              const float factor = COMET_MIN_SPEED / sqrtf(speedSq);
+              vx *= factor;
+              vy *= factor;
           }
+
+          // Bounce off screen edges; a comet pushed back off both edges keeps its direction
+          const float r = radius[i];
+          const bool left = x - r < 0;
+          x = left ? r : x;
+          const bool right = x + r > SCREEN_WIDTH;
+          x = right ? SCREEN_WIDTH - r : x;
+          vx = left != right ? -vx : vx;
+
+          const bool top = y - r < 0;
+          y = top ? r : y;
+          const bool bottom = y + r > SCREEN_HEIGHT;
+          y = bottom ? SCREEN_HEIGHT - r : y;
+          vy = top != bottom ? -vy : vy;
+
+          posX[i] = x;
+          posY[i] = y;
+          velX[i] = vx;
+          velY[i] = vy;
       }
+  }
 
-      // Big Comets vs. Normal Comets
-      for (size_t i = 0; i < bigComets.size(); i++) {
-          for (size_t j = 0; j < comets.size(); j++) {
-              BigComet& bc = bigComets[i];
-              Comet& c = comets[j];
-
-              float dx = c.position.x - bc.position.x;
-              float dy = c.position.y - bc.position.y;
-              float dist = sqrtf(dx*dx + dy*dy);
-              float minDist = bc.radius + c.radius;
-
-              if (dist < minDist && dist > 0) {
-                  float nx = dx / dist;
-                  float ny = dy / dist;
-                  float overlap = minDist - dist;
-
-                  // Adjust positions so they bounce apart
-                  c.position.x += nx * (overlap / 2.0f);
-                  c.position.y += ny * (overlap / 2.0f);
-                  bc.position.x -= nx * (overlap / 2.0f);
-                  bc.position.y -= ny * (overlap / 2.0f);
-
-                  // Bounce the normal comet more strongly
-                  c.velocity.x = -c.velocity.x * 0.5f;
-                  c.velocity.y = -c.velocity.y * 0.5f;
-              }
-          }
+  // Move particles, age them and shrink them
+  void IntegrateParticlesScalar(float* posX, float* posY, const float* velX, const float* velY, float* lifetime, float* size, int count, float dt) {
+      for (int i = 0; i < count; i++) {
+          posX[i] += velX[i] * dt;
+          posY[i] += velY[i] * dt;
+          lifetime[i] -= dt;
+          size[i] *= 0.98f;
       }
   }
 
-  // Spawn a power-up
-  PowerUp SpawnPowerUp() {
-      Vector2 loc = GetSpawnLocation();
+  // value += rate * dt over a column
+  void AdvanceScalar(float* value, const float* rate, int count, float dt) {
+      for (int i = 0; i < count; i++) {
+          value[i] += rate[i] * dt;
+      }
+  }
 
-      PowerUp powerUp;
-      powerUp.position = loc;
-      powerUp.velocity = (Vector2){
-          RandomRange(-50.0f, 50.0f),
-          RandomRange(-50.0f, 50.0f)
+  #ifdef COMETS_X86_SIMD
+  // SSE2 versions, 4 entities per instruction. Lanes select with and/andnot
+  // masks, and the remainder goes through the scalar kernels.
+  void IntegrateCometsSSE2(float* posX, float* posY, float* velX, float* velY, const float* radius, int count, float dt) {
+      const __m128 step = _mm_set1_ps(dt);
+      const __m128 friction = _mm_set1_ps(COMET_FRICTION);
+      const __m128 minSpeed = _mm_set1_ps(COMET_MIN_SPEED);
+      const __m128 minSpeedSq = _mm_set1_ps(COMET_MIN_SPEED * COMET_MIN_SPEED);
+      const __m128 zero = _mm_setzero_ps();
+      const __m128 one = _mm_set1_ps(1.0f);
+      const __m128 width = _mm_set1_ps(SCREEN_WIDTH);
+      const __m128 height = _mm_set1_ps(SCREEN_HEIGHT);
+      const __m128 signBit = _mm_set1_ps(-0.0f);
+
+      auto select = [](__m128 mask, __m128 a, __m128 b) {
+          return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
       };
-      powerUp.lifetime = 10.0f;
-      powerUp.radius = POWERUP_RADIUS;
 
-      return powerUp;
+      int i = 0;
+      for (; i + 4 <= count; i += 4) {
+          __m128 vx = _mm_loadu_ps(velX + i);
+          __m128 vy = _mm_loadu_ps(velY + i);
+          __m128 x = _mm_add_ps(_mm_loadu_ps(posX + i), _mm_mul_ps(vx, step));
+          __m128 y = _mm_add_ps(_mm_loadu_ps(posY + i), _mm_mul_ps(vy, step));
+          vx = _mm_mul_ps(vx, friction);
+          vy = _mm_mul_ps(vy, friction);
+
+          // Lanes outside the speed clamp scale by one
+          const __m128 speedSq = _mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy));
+          const __m128 slow = _mm_and_ps(_mm_cmplt_ps(speedSq, minSpeedSq), _mm_cmpgt_ps(speedSq, zero));
+          const __m128 factor = select(slow, _mm_div_ps(minSpeed, _mm_sqrt_ps(speedSq)), one);
+          vx = _mm_mul_ps(vx, factor);
+          vy = _mm_mul_ps(vy, factor);
+
+          const __m128 r = _mm_loadu_ps(radius + i);
+          const __m128 left = _mm_cmplt_ps(_mm_sub_ps(x, r), zero);
+          x = select(left, r, x);
+          const __m128 right = _mm_cmpgt_ps(_mm_add_ps(x, r), width);
+          x = select(right, _mm_sub_ps(width, r), x);
+          vx = _mm_xor_ps(vx, _mm_and_ps(_mm_xor_ps(left, right), signBit));
+
+          const __m128 top = _mm_cmplt_ps(_mm_sub_ps(y, r), zero);
+          y = select(top, r, y);
+          const __m128 bottom = _mm_cmpgt_ps(_mm_add_ps(y, r), height);
+          y = select(bottom, _mm_sub_ps(height, r), y);
+          vy = _mm_xor_ps(vy, _mm_and_ps(_mm_xor_ps(top, bottom), signBit));
+
+          _mm_storeu_ps(posX + i, x);
+          _mm_storeu_ps(posY + i, y);
+          _mm_storeu_ps(velX + i, vx);
+          _mm_storeu_ps(velY + i, vy);
+      }
+
+      IntegrateCometsScalar(posX + i, posY + i, velX + i, velY + i, radius + i, count - i, dt);
   }
 
-  // Toggle music on/off
-  void ToggleMusic() {
-      musicEnabled = !musicEnabled;
-      soundEnabled = musicEnabled; // Link sound effects to music toggle
+  void IntegrateParticlesSSE2(float* posX, float* posY, const float* velX, const float* velY, float* lifetime, float* size, int count, float dt) {
+      const __m128 step = _mm_set1_ps(dt);
+      const __m128 shrink = _mm_set1_ps(0.98f);
 
-      if (musicEnabled) {
-          // Resume music based on current game state
-          if (gameState == MENU || gameState == SETTINGS) {
-              StartMenuMusic();
-          } else if (gameState == PLAYING) {
-              StartGameplayMusic();
-          }
-      } else {
-          // Stop music
-          StopMusicStream(menuMusic);
-          StopMusicStream(gameplayMusic);
+      int i = 0;
+      for (; i + 4 <= count; i += 4) {
+          _mm_storeu_ps(posX + i, _mm_add_ps(_mm_loadu_ps(posX + i), _mm_mul_ps(_mm_loadu_ps(velX + i), step)));
+          _mm_storeu_ps(posY + i, _mm_add_ps(_mm_loadu_ps(posY + i), _mm_mul_ps(_mm_loadu_ps(velY + i), step)));
+          _mm_storeu_ps(lifetime + i, _mm_sub_ps(_mm_loadu_ps(lifetime + i), step));
+          _mm_storeu_ps(size + i, _mm_mul_ps(_mm_loadu_ps(size + i), shrink));
       }
+
+      IntegrateParticlesScalar(posX + i, posY + i, velX + i, velY + i, lifetime + i, size + i, count - i, dt);
   }
 
-  // Toggle all sounds
-  void ToggleAllSounds() {
-      soundEnabled = !soundEnabled;
+  void AdvanceSSE2(float* value, const float* rate, int count, float dt) {
+      const __m128 step = _mm_set1_ps(dt);
 
-      if (!soundEnabled) {
-          // Turn off music
-          musicEnabled = false;
-          StopMusicStream(menuMusic);
-          StopMusicStream(gameplayMusic);
+      int i = 0;
+      for (; i + 4 <= count; i += 4) {
+          _mm_storeu_ps(value + i, _mm_add_ps(_mm_loadu_ps(value + i), _mm_mul_ps(_mm_loadu_ps(rate + i), step)));
       }
+
+      AdvanceScalar(value + i, rate + i, count - i, dt);
   }
 
-  // Start menu music
-  void StartMenuMusic() {
-      StopMusicStream(gameplayMusic);
+  // AVX2 versions, 8 entities per instruction. Compiled for AVX2 only (no FMA),
+  // so products and sums round separately, as in the scalar kernels.
+  __attribute__((target("avx2")))
+  void IntegrateCometsAVX2(float* posX, float* posY, float* velX, float* velY, const float* radius, int count, float dt) {
+      const __m256 step = _mm256_set1_ps(dt);
+      const __m256 friction = _mm256_set1_ps(COMET_FRICTION);
+      const __m256 minSpeed = _mm256_set1_ps(COMET_MIN_SPEED);
+      const __m256 minSpeedSq = _mm256_set1_ps(COMET_MIN_SPEED * COMET_MIN_SPEED);
+      const __m256 zero = _mm256_setzero_ps();
+      const __m256 one = _mm256_set1_ps(1.0f);
+      const __m256 width = _mm256_set1_ps(SCREEN_WIDTH);
+      const __m256 height = _mm256_set1_ps(SCREEN_HEIGHT);
+      const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+      int i = 0;
+      for (; i + 8 <= count; i += 8) {
+          __m256 vx = _mm256_loadu_ps(velX + i);
+          __m256 vy = _mm256_loadu_ps(velY + i);
+          __m256 x = _mm256_add_ps(_mm256_loadu_ps(posX + i), _mm256_mul_ps(vx, step));
+          __m256 y = _mm256_add_ps(_mm256_loadu_ps(posY + i), _mm256_mul_ps(vy, step));
+          vx = _mm256_mul_ps(vx, friction);
+          vy = _mm256_mul_ps(vy, friction);
+
+          // Lanes outside the speed clamp scale by one
+          const __m256 speedSq = _mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy));
+          const __m256 slow = _mm256_and_ps(_mm256_cmp_ps(speedSq, minSpeedSq, _CMP_LT_OQ), _mm256_cmp_ps(speedSq, zero, _CMP_GT_OQ));
+          const __m256 factor = _mm256_blendv_ps(one, _mm256_div_ps(minSpeed, _mm256_sqrt_ps(speedSq)), slow);
+          vx = _mm256_mul_ps(vx, factor);
+          vy = _mm256_mul_ps(vy, factor);
+
+          const __m256 r = _mm256_loadu_ps(radius + i);
+          const __m256 left = _mm256_cmp_ps(_mm256_sub_ps(x, r), zero, _CMP_LT_OQ);
+          x = _mm256_blendv_ps(x, r, left);
+          const __m256 right = _mm256_cmp_ps(_mm256_add_ps(x, r), width, _CMP_GT_OQ);
+          x = _mm256_blendv_ps(x, _mm256_sub_ps(width, r), right);
+          vx = _mm256_xor_ps(vx, _mm256_and_ps(_mm256_xor_ps(left, right), signBit));
+
+          const __m256 top = _mm256_cmp_ps(_mm256_sub_ps(y, r), zero, _CMP_LT_OQ);
+          y = _mm256_blendv_ps(y, r, top);
+          const __m256 bottom = _mm256_cmp_ps(_mm256_add_ps(y, r), height, _CMP_GT_OQ);
+          y = _mm256_blendv_ps(y, _mm256_sub_ps(height, r), bottom);
+          vy = _mm256_xor_ps(vy, _mm256_and_ps(_mm256_xor_ps(top, bottom), signBit));
+
+          _mm256_storeu_ps(posX + i, x);
+          _mm256_storeu_ps(posY + i, y);
+          _mm256_storeu_ps(velX + i, vx);
+          _mm256_storeu_ps(velY + i, vy);
+      }
 
-      if (musicEnabled) {
-          PlayMusicStream(menuMusic);
+      IntegrateCometsSSE2(posX + i, posY + i, velX + i, velY + i, radius + i, count - i, dt);
+  }
+
+  __attribute__((target("avx2")))
+  void IntegrateParticlesAVX2(float* posX, float* posY, const float* velX, const float* velY, float* lifetime, float* size, int count, float dt) {
+      const __m256 step = _mm256_set1_ps(dt);
+      const __m256 shrink = _mm256_set1_ps(0.98f);
+
+      int i = 0;
+      for (; i + 8 <= count; i += 8) {
+          _mm256_storeu_ps(posX + i, _mm256_add_ps(_mm256_loadu_ps(posX + i), _mm256_mul_ps(_mm256_loadu_ps(velX + i), step)));
+          _mm256_storeu_ps(posY + i, _mm256_add_ps(_mm256_loadu_ps(posY + i), _mm256_mul_ps(_mm256_loadu_ps(velY + i), step)));
+          _mm256_storeu_ps(lifetime + i, _mm256_sub_ps(_mm256_loadu_ps(lifetime + i), step));
+          _mm256_storeu_ps(size + i, _mm256_mul_ps(_mm256_loadu_ps(size + i), shrink));
       }
+
+      IntegrateParticlesSSE2(posX + i, posY + i, velX + i, velY + i, lifetime + i, size + i, count - i, dt);
   }
 
-  // Start gameplay music
-  void StartGameplayMusic() {
-      StopMusicStream(menuMusic);
+  __attribute__((target("avx2")))
+  void AdvanceAVX2(float* value, const float* rate, int count, float dt) {
+      const __m256 step = _mm256_set1_ps(dt);
 
-      if (musicEnabled) {
-          PlayMusicStream(gameplayMusic);
+      int i = 0;
+      for (; i + 8 <= count; i += 8) {
+          _mm256_storeu_ps(value + i, _mm256_add_ps(_mm256_loadu_ps(value + i), _mm256_mul_ps(_mm256_loadu_ps(rate + i), step)));
       }
+
+      AdvanceSSE2(value + i, rate + i, count - i, dt);
+  }
+  #endif
+
+  const IntegrationKernels scalarKernels = { "scalar", IntegrateCometsScalar, IntegrateParticlesScalar, AdvanceScalar };
+  #ifdef COMETS_X86_SIMD
+  const IntegrationKernels sse2Kernels = { "SSE2", IntegrateCometsSSE2, IntegrateParticlesSSE2, AdvanceSSE2 };
+  const IntegrationKernels avx2Kernels = { "AVX2", IntegrateCometsAVX2, IntegrateParticlesAVX2, AdvanceAVX2 };
+  #endif
+
+  // Widest kernel set the CPU runs
+  const IntegrationKernels* SelectKernels() {
+  #ifdef COMETS_X86_SIMD
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2")) return &avx2Kernels;
+      return &sse2Kernels;
+  #else
+      return &scalarKernels;
+  #endif
   }
 
-  // Restart the game
-  void RestartGame() {
-      gameState = MENU;
-      StartMenuMusic();
+  // Time every kernel set at 1k/10k/100k entities and report entities per
+  // microsecond, checking each set's output against the scalar one
+  int RunKernelBenchmark() {
+      std::vector<const IntegrationKernels*> sets = { &scalarKernels };
+  #ifdef COMETS_X86_SIMD
+      sets.push_back(&sse2Kernels);
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2")) sets.push_back(&avx2Kernels);
+  #endif
+
+      const float dt = 1.0f / 60.0f;
+      const int counts[] = { 1000, 10000, 100000 };
+      bool identical = true;
+
+      printf("%-10s %-8s %8s %14s\n", "kernel", "set", "entities", "entities/us");
+      for (int count : counts) {
+          // Comets spread over the screen and a little past it, some slow enough to clamp
+          SeedRandom(12345);
+          std::vector<float> startX(count), startY(count), startVX(count), startVY(count), radius(count);
+          for (int i = 0; i < count; i++) {
+              startX[i] = RandomRange(-20.0f, SCREEN_WIDTH + 20.0f);
+              startY[i] = RandomRange(-20.0f, SCREEN_HEIGHT + 20.0f);
+              startVX[i] = RandomRange(-COMET_SPEED_MAX, COMET_SPEED_MAX);
+              startVY[i] = RandomRange(-COMET_SPEED_MAX, COMET_SPEED_MAX);
+              radius[i] = BASE_COMET_RADIUS * powf(0.6f, RandomInt(0, MAX_COMET_TIER - 1));
+          }
 
-      ship.position = (Vector2){ SCREEN_WIDTH / 2.0f, SCREEN_HEIGHT / 2.0f };
+          // Roughly the same amount of work per measurement at every size
+          const int iterations = std::max(10, 20000000 / count);
+          std::vector<float> expectX, expectY, expectVX, expectVY;
+
+          for (const IntegrationKernels* set : sets) {
+              std::vector<float> x = startX, y = startY, vx = startVX, vy = startVY;
+              std::vector<float> lifetime(count, 1.0e9f), size(count, 1.0f);
+
+              auto start = std::chrono::steady_clock::now();
+              for (int k = 0; k < iterations; k++) {
+                  set->integrateComets(x.data(), y.data(), vx.data(), vy.data(), radius.data(), count, dt);
+              }
+              double cometUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+              // Particles and bullets integrate copies of the comet state. Particles
+              // are refreshed every 90 updates, about the longest one lives, so their
+              // sizes never shrink into denormals.
+              std::vector<float> px = x, py = y;
+              start = std::chrono::steady_clock::now();
+              for (int k = 0; k < iterations; k++) {
+                  if (k % 90 == 0) std::fill(size.begin(), size.end(), 1.0f);
+                  set->integrateParticles(px.data(), py.data(), vx.data(), vy.data(), lifetime.data(), size.data(), count, dt);
+              }
+              double particleUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+              start = std::chrono::steady_clock::now();
+              for (int k = 0; k < iterations; k++) {
+                  set->advance(px.data(), vx.data(), count, dt);
+                  set->advance(py.data(), vy.data(), count, dt);
+              }
+              double bulletUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+              const double processed = (double)count * iterations;
+              printf("%-10s %-8s %8d %14.1f\n", "comets", set->name, count, processed / cometUs);
+              printf("%-10s %-8s %8d %14.1f\n", "particles", set->name, count, processed / particleUs);
+              printf("%-10s %-8s %8d %14.1f\n", "bullets", set->name, count, processed / bulletUs);
+
+              if (set == sets[0]) {
+                  expectX = x;
+                  expectY = y;
+                  expectVX = vx;
+                  expectVY = vy;
+              } else if (x != expectX || y != expectY || vx != expectVX || vy != expectVY) {
+                  printf("%s comet results differ from scalar at %d entities\n", set->name, count);
+                  identical = false;
+              }
+          }
+      }
+
+      printf(identical ? "All kernel sets match the scalar results\n" : "Kernel sets disagree\n");
+      return identical ? 0 : 1;
+  }
+
+  // Append a trail point, dropping the oldest once the trail is full
+  void PushTrailPoint(CometTrail& trail, float x, float y) {
+      if (trail.count == COMET_TRAIL_LENGTH) {
+          std::copy(trail.points + 1, trail.points + COMET_TRAIL_LENGTH, trail.points);
+          trail.count--;
+      }
+      trail.points[trail.count++] = (TrailPoint){x, y};
+  }
+
+  // Remove an element by moving the last one into its place
+  template <typename T>
+  void SwapPop(std::vector<T>& column, int index) {
+      column[index] = column.back();
+      column.pop_back();
+  }
+
+  // Hand out a slot for an entity appended to the end of the dense columns
+  int AllocateHandle(HandleTable& handles) {
+      uint32_t slot;
+      if (!handles.freeSlots.empty()) {
+          slot = handles.freeSlots.back();
+          handles.freeSlots.pop_back();
+      } else {
+          slot = handles.generations.size();
+          handles.generations.push_back(0);
+          handles.slotToDense.push_back(0);
+      }
+
+      const int index = handles.denseToSlot.size();
+      handles.denseToSlot.push_back(slot);
+      handles.killed.push_back(0);
+      handles.slotToDense[slot] = index;
+      return index;
+  }
+
+  // Mirror a SwapPop of the dense columns and retire the removed entity's slot
+  void ReleaseHandle(HandleTable& handles, int index) {
+      const uint32_t slot = handles.denseToSlot[index];
+      handles.slotToDense[handles.denseToSlot.back()] = index;
+      SwapPop(handles.denseToSlot, index);
+      SwapPop(handles.killed, index);
+
+      handles.generations[slot]++;
+      handles.freeSlots.push_back(slot);
+  }
+
+  // Retire every live slot, so all outstanding handles go stale
+  void ClearHandles(HandleTable& handles) {
+      for (auto slot : handles.denseToSlot) {
+          handles.generations[slot]++;
+          handles.freeSlots.push_back(slot);
+      }
+      handles.denseToSlot.clear();
+      handles.killed.clear();
+      handles.killList.clear();
+  }
+
+  // Handle for the entity currently at a dense index
+  EntityHandle GetHandle(const HandleTable& handles, int index) {
+      const uint32_t slot = handles.denseToSlot[index];
+      return (EntityHandle){ slot, handles.generations[slot] };
+  }
+
+  // Dense index of a handle's entity; -1 once it has been removed
+  int ResolveHandle(const HandleTable& handles, EntityHandle handle) {
+      if (handle.slot >= handles.generations.size() || handles.generations[handle.slot] != handle.generation) {
+          return -1;
+      }
+      return handles.slotToDense[handle.slot];
+  }
+
+  // Apply fn to every column of a store
+  template <typename Fn>
+  void ForEachColumn(CometStore& store, Fn fn) {
+      fn(store.posX);
+      fn(store.posY);
+      fn(store.velX);
+      fn(store.velY);
+      fn(store.radius);
+      fn(store.hitEffectTimer);
+      fn(store.slowEffectTimer);
+      fn(store.indestructableTimer);
+      fn(store.trailTimer);
+      fn(store.rotationSpeed);
+      fn(store.tier);
+      fn(store.hitPoints);
+      fn(store.color);
+      fn(store.morph);
+      fn(store.trail);
+      fn(store.shapeId);
+  }
+
+  template <typename Fn>
+  void ForEachColumn(BigCometStore& store, Fn fn) {
+      fn(store.posX);
+      fn(store.posY);
+      fn(store.velX);
+      fn(store.velY);
+      fn(store.radius);
+      fn(store.rotationSpeed);
+      fn(store.color);
+      fn(store.morph);
+      fn(store.shapeId);
+  }
+
+  template <typename Fn>
+  void ForEachColumn(BulletStore& store, Fn fn) {
+      fn(store.posX);
+      fn(store.posY);
+      fn(store.velX);
+      fn(store.velY);
+      fn(store.radius);
+  }
+
+  template <typename Fn>
+  void ForEachColumn(PowerUpStore& store, Fn fn) {
+      fn(store.posX);
+      fn(store.posY);
+      fn(store.velX);
+      fn(store.velY);
+      fn(store.lifetime);
+      fn(store.radius);
+  }
+
+  // Number of entities in a store, killed ones included until the flush
+  template <typename Store>
+  int EntityCount(const Store& store) {
+      return store.handles.denseToSlot.size();
+  }
+
+  // Append an entity with every field value-initialized; returns its dense index
+  template <typename Store>
+  int AddEntity(Store& store) {
+      ForEachColumn(store, [](auto& column) { column.emplace_back(); });
+      return AllocateHandle(store.handles);
+  }
+
+  // Queue an entity for removal at the end of the update
+  template <typename Store>
+  void KillEntity(Store& store, int index) {
+      HandleTable& handles = store.handles;
+      if (handles.killed[index]) return;
+
+      handles.killed[index] = 1;
+      handles.killList.push_back(handles.denseToSlot[index]);
+  }
+
+  template <typename Store>
+  bool IsKilled(const Store& store, int index) {
+      return store.handles.killed[index];
+  }
+
+  // Swap every killed entity out of the dense columns
+  template <typename Store>
+  void FlushKills(Store& store) {
+      HandleTable& handles = store.handles;
+      for (auto slot : handles.killList) {
+          const int index = handles.slotToDense[slot];
+          ForEachColumn(store, [index](auto& column) { SwapPop(column, index); });
+          ReleaseHandle(handles, index);
+      }
+      handles.killList.clear();
+  }
+
+  // Remove every entity from a store
+  template <typename Store>
+  void ClearEntities(Store& store) {
+      ForEachColumn(store, [](auto& column) { column.clear(); });
+      ClearHandles(store.handles);
+  }
+
+  // Clamp the cells touched by a box of half-size r around (x, y) to the grid
+  void GetGridCellRange(float x, float y, float r, int& x0, int& y0, int& x1, int& y1) {
+      x0 = std::max(0, std::min(GRID_COLS - 1, (int)floorf((x - r) / GRID_CELL_SIZE)));
+      y0 = std::max(0, std::min(GRID_ROWS - 1, (int)floorf((y - r) / GRID_CELL_SIZE)));
+      x1 = std::max(0, std::min(GRID_COLS - 1, (int)floorf((x + r) / GRID_CELL_SIZE)));
+      y1 = std::max(0, std::min(GRID_ROWS - 1, (int)floorf((y + r) / GRID_CELL_SIZE)));
+  }
+
+  // Bin every item into the cells its margin-grown bounding box overlaps
+  template <typename Store>
+  void BuildGrid(SpatialGrid& grid, const Store& items) {
+      const int cellCount = GRID_COLS * GRID_ROWS;
+      const int count = EntityCount(items);
+
+      grid.cellStart.assign(cellCount + 1, 0);
+      grid.builtX.resize(count);
+      grid.builtY.resize(count);
+      grid.halfSize.resize(count);
+      grid.moved.assign(count, 0);
+      grid.movedHead.assign(cellCount, -1);
+      grid.moveNext.clear();
+      grid.moveEntries.clear();
+      grid.latestMove.resize(count);
+      grid.builtCount = count;
+
+      // Count entries per cell
+      for (int i = 0; i < count; i++) {
+          grid.builtX[i] = items.posX[i];
+          grid.builtY[i] = items.posY[i];
+          grid.halfSize[i] = items.radius[i] + GRID_MARGIN;
+
+          int x0, y0, x1, y1;
+          GetGridCellRange(grid.builtX[i], grid.builtY[i], grid.halfSize[i], x0, y0, x1, y1);
+          for (int cy = y0; cy <= y1; cy++) {
+              for (int cx = x0; cx <= x1; cx++) {
+                  grid.cellStart[cy * GRID_COLS + cx + 1]++;
+              }
+          }
+      }
+
+      // A query covers about four cells, each as full as the cell an average entry sits in
+      long entries = 0;
+      long squares = 0;
+      for (int c = 0; c < cellCount; c++) {
+          entries += grid.cellStart[c + 1];
+          squares += (long)grid.cellStart[c + 1] * grid.cellStart[c + 1];
+      }
+      grid.queryScans = 4.0f * squares / std::max(1L, entries);
+
+      // Turn counts into offsets, then fill the buckets in index order
+      for (int c = 0; c < cellCount; c++) {
+          grid.cellStart[c + 1] += grid.cellStart[c];
+      }
+      grid.cellEntries.resize(grid.cellStart[cellCount]);
+      grid.cellEnd.assign(grid.cellStart.begin(), grid.cellStart.end() - 1);
+
+      for (int i = 0; i < count; i++) {
+          GridEntry entry = { grid.builtX[i], grid.builtY[i], grid.halfSize[i], i };
+
+          int x0, y0, x1, y1;
+          GetGridCellRange(entry.x, entry.y, entry.halfSize, x0, y0, x1, y1);
+          for (int cy = y0; cy <= y1; cy++) {
+              for (int cx = x0; cx <= x1; cx++) {
+                  grid.cellEntries[grid.cellEnd[cy * GRID_COLS + cx]++] = entry;
+              }
+          }
+      }
+  }
+
+  // Collect, in ascending order, every item in [firstItem, itemCount) whose binned box
+  // overlaps the box of half-size r around (x, y). Items spawned since the build
+  // are always included.
+  void QueryGrid(SpatialGrid& grid, float x, float y, float r, int firstItem, int itemCount, std::vector<int>& out) {
+      out.clear();
+
+      const int builtCount = std::min(itemCount, grid.builtCount);
+      grid.queryMask.resize((builtCount + 63) / 64, 0);
+      int firstWord = grid.queryMask.size();
+      int lastWord = -1;
+
+      auto mark = [&](int item) {
+          const int word = item / 64;
+          grid.queryMask[word] |= (uint64_t)1 << (item % 64);
+          firstWord = std::min(firstWord, word);
+          lastWord = std::max(lastWord, word);
+      };
+
+      auto overlaps = [&](const GridEntry& e) {
+          return e.item >= firstItem && e.item < builtCount &&
+                 fabsf(x - e.x) < r + e.halfSize &&
+                 fabsf(y - e.y) < r + e.halfSize;
+      };
+
+      int x0, y0, x1, y1;
+      GetGridCellRange(x, y, r, x0, y0, x1, y1);
+      for (int cy = y0; cy <= y1; cy++) {
+          for (int cx = x0; cx <= x1; cx++) {
+              const int cell = cy * GRID_COLS + cx;
+
+              // Entries of items binned again are dropped on sight, so each
+              // stale entry is scanned only once
+              for (int k = grid.cellStart[cell]; k < grid.cellEnd[cell]; ) {
+                  const GridEntry& e = grid.cellEntries[k];
+                  if (grid.moved[e.item]) {
+                      grid.cellEntries[k] = grid.cellEntries[--grid.cellEnd[cell]];
+                      continue;
+                  }
+                  if (overlaps(e)) mark(e.item);
+                  k++;
+              }
+
+              // Only an item's entries from its latest binning still hold
+              int* link = &grid.movedHead[cell];
+              while (*link >= 0) {
+                  const int k = *link;
+                  const GridEntry& e = grid.moveEntries[k];
+                  if (k < grid.latestMove[e.item]) {
+                      *link = grid.moveNext[k];
+                      continue;
+                  }
+                  if (overlaps(e)) mark(e.item);
+                  link = &grid.moveNext[k];
+              }
+          }
+      }
+
+      // Drain the marked bits in index order
+      for (int word = firstWord; word <= lastWord; word++) {
+          uint64_t bits = grid.queryMask[word];
+          grid.queryMask[word] = 0;
+          while (bits) {
+              out.push_back(word * 64 + __builtin_ctzll(bits));
+              bits &= bits - 1;
+          }
+      }
+
+      for (int item = std::max(firstItem, builtCount); item < itemCount; item++) {
+          out.push_back(item);
+      }
+  }
+
+  // Record a position change made after the build, binning the entity again once
+  // it leaves its box
+  void NoteGridMove(SpatialGrid& grid, int index, float x, float y) {
+      if (index >= grid.builtCount) return;
+
+      float dx = x - grid.builtX[index];
+      float dy = y - grid.builtY[index];
+      if (dx*dx + dy*dy <= GRID_MARGIN * GRID_MARGIN) return;
+
+      grid.builtX[index] = x;
+      grid.builtY[index] = y;
+      grid.moved[index] = 1;
+      grid.latestMove[index] = grid.moveEntries.size();
+
+      const GridEntry entry = { x, y, grid.halfSize[index], index };
+      int x0, y0, x1, y1;
+      GetGridCellRange(x, y, entry.halfSize, x0, y0, x1, y1);
+      for (int cy = y0; cy <= y1; cy++) {
+          for (int cx = x0; cx <= x1; cx++) {
+              const int cell = cy * GRID_COLS + cx;
+              grid.moveNext.push_back(grid.movedHead[cell]);
+              grid.movedHead[cell] = grid.moveEntries.size();
+              grid.moveEntries.push_back(entry);
+          }
+      }
+  }
+
+  // Call resolve(i, j) for the pairs of the brute-force double loop, in the same
+  // order. With useGrid, pairs the grid rules out are skipped, unless the grid is
+  // crowded enough that brute force is cheaper; the query around item i is redone
+  // whenever resolving pushes it more than GRID_MARGIN away.
+  template <typename A, typename B, typename Resolve>
+  void ForEachCandidatePair(const A& itemsA, SpatialGrid& gridB, const B& itemsB, bool sameSet, bool useGrid, Resolve resolve) {
+      const int countA = EntityCount(itemsA);
+      const int countB = EntityCount(itemsB);
+      std::vector<int>& candidates = broadPhaseCandidates;
+
+      // In a crowd packed tight enough, queries see most of the items anyway
+      const float pairs = sameSet ? 0.5f * countA * (countA - 1) : (float)countA * countB;
+      if (GRID_SCAN_COST * countA * gridB.queryScans > pairs) useGrid = false;
+
+      for (int i = 0; i < countA; i++) {
+          int next = sameSet ? i + 1 : 0;
+
+          if (!useGrid) {
+              for (int j = next; j < countB; j++) {
+                  resolve(i, j);
+              }
+              continue;
+          }
+
+          bool requery = true;
+          while (requery && next < countB) {
+              const float qx = itemsA.posX[i];
+              const float qy = itemsA.posY[i];
+              const float qr = itemsA.radius[i] + GRID_MARGIN;
+              QueryGrid(gridB, qx, qy, qr, next, countB, candidates);
+              requery = false;
+
+              for (auto j : candidates) {
+                  next = j + 1;
+
+                  resolve(i, j);
+
+                  float dx = itemsA.posX[i] - qx;
+                  float dy = itemsA.posY[i] - qy;
+                  if (dx*dx + dy*dy > GRID_MARGIN * GRID_MARGIN) {
+                      requery = true;
+                      break;
+                  }
+              }
+          }
+      }
+  }
+
+  // Run a collision pass, or with verifyBroadPhase run it through the grid and
+  // brute force from the same state and report any difference. The brute-force
+  // outcome is the one kept.
+  template <typename Pass>
+  void RunCollisionPass(const char* name, Pass pass) {
+      if (!verifyBroadPhase) {
+          pass(true);
+          return;
+      }
+
+      const CometStore startComets = comets;
+      const BigCometStore startBigComets = bigComets;
+      const std::unique_ptr<ParticleStore> startParticles = std::make_unique<ParticleStore>(explosionParticles);
+      const SpatialGrid startCometGrid = cometGrid;
+      const SpatialGrid startBigCometGrid = bigCometGrid;
+      const std::mt19937 startRng = *rng;
+      const size_t startSounds = soundEvents.size();
+      const int startScore = score;
+
+      auto start = std::chrono::steady_clock::now();
+      pass(true);
+      gridPassSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      const CometStore gridComets = comets;
+      const BigCometStore gridBigComets = bigComets;
+      const int gridScore = score;
+
+      comets = startComets;
+      bigComets = startBigComets;
+      explosionParticles = *startParticles;
+      cometGrid = startCometGrid;
+      bigCometGrid = startBigCometGrid;
+      *rng = startRng;
+      soundEvents.resize(startSounds);
+      score = startScore;
+
+      start = std::chrono::steady_clock::now();
+      pass(false);
+      brutePassSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      int diff = FindMotionDifference(gridComets, comets);
+      if (diff >= 0) ReportBroadPhaseMismatch(name, diff);
+
+      diff = FindMotionDifference(gridBigComets, bigComets);
+      if (diff >= 0) ReportBroadPhaseMismatch(name, diff);
+
+      // Kill order decides where survivors land when the kills are flushed
+      if (gridComets.handles.killList != comets.handles.killList) ReportBroadPhaseMismatch(name, -1);
+      if (gridScore != score) ReportBroadPhaseMismatch(name, -1);
+  }
+
+  // Index of the first item whose position or velocity differs; -1 if none
+  template <typename Store>
+  int FindMotionDifference(const Store& a, const Store& b) {
+      const int countA = EntityCount(a);
+      const int countB = EntityCount(b);
+      if (countA != countB) return std::min(countA, countB);
+
+      for (int i = 0; i < countA; i++) {
+          if (a.posX[i] != b.posX[i] || a.posY[i] != b.posY[i] ||
+              a.velX[i] != b.velX[i] || a.velY[i] != b.velY[i]) {
+              return i;
+          }
+      }
+      return -1;
+  }
+
+  // Log an outcome where the grid and brute force disagreed
+  void ReportBroadPhaseMismatch(const char* pass, int index) {
+      broadPhaseMismatches++;
+      TraceLog(LOG_WARNING, "Broad phase mismatch in %s pass at index %d", pass, index);
+  }
+
+  // Check if a bullet at (x, y) hits a normal comet
+  bool BulletHitsComet(float x, float y, int index) {
+      if (IsKilled(comets, index) || comets.indestructableTimer[index] > 0) return false;
+
+      float dx = x - comets.posX[index];
+      float dy = y - comets.posY[index];
+      return dx*dx + dy*dy < comets.radius[index] * comets.radius[index];
+  }
+
+  // Check if a bullet at (x, y) hits a big comet
+  bool BulletHitsBigComet(float x, float y, int index) {
+      if (IsKilled(bigComets, index)) return false;
+
+      float dx = x - bigComets.posX[index];
+      float dy = y - bigComets.posY[index];
+      return dx*dx + dy*dy < bigComets.radius[index] * bigComets.radius[index];
+  }
+
+  // Find the comet a bullet hits, trying the highest index first; -1 if none
+  int FindBulletTarget(float x, float y) {
+      QueryGrid(cometGrid, x, y, 0.0f, 0, EntityCount(comets), broadPhaseCandidates);
+
+      int target = -1;
+      for (int k = broadPhaseCandidates.size() - 1; k >= 0; k--) {
+          if (BulletHitsComet(x, y, broadPhaseCandidates[k])) {
+              target = broadPhaseCandidates[k];
+              break;
+          }
+      }
+
+      if (verifyBroadPhase) {
+          int expected = -1;
+          for (int j = EntityCount(comets) - 1; j >= 0; j--) {
+              if (BulletHitsComet(x, y, j)) {
+                  expected = j;
+                  break;
+              }
+          }
+          if (expected != target) {
+              ReportBroadPhaseMismatch("bullet", expected);
+              target = expected;
+          }
+      }
+
+      return target;
+  }
+
+  // Check if a bullet hits any big comet
+  bool FindBulletBigCometHit(float x, float y) {
+      QueryGrid(bigCometGrid, x, y, 0.0f, 0, EntityCount(bigComets), broadPhaseCandidates);
+
+      bool hit = false;
+      for (auto j : broadPhaseCandidates) {
+          if (BulletHitsBigComet(x, y, j)) {
+              hit = true;
+              break;
+          }
+      }
+
+      if (verifyBroadPhase) {
+          bool expected = false;
+          for (int j = 0; j < EntityCount(bigComets); j++) {
+              if (BulletHitsBigComet(x, y, j)) {
+                  expected = true;
+                  break;
+              }
+          }
+          if (expected != hit) {
+              ReportBroadPhaseMismatch("bullet/big comet", -1);
+              hit = expected;
+          }
+      }
+
+      return hit;
+  }
+
+  // Resolve a contact between two normal comets
+  bool ResolveCometPair(int i, int j, std::vector<int>& indicesToRemove) {
+      if (IsKilled(comets, i) || IsKilled(comets, j)) return false;
+
+      float dx = comets.posX[j] - comets.posX[i];
+      float dy = comets.posY[j] - comets.posY[i];
+      float distSq = dx*dx + dy*dy;
+      float minDist = comets.radius[i] + comets.radius[j];
+
+      if (distSq >= minDist * minDist || distSq <= 0) return false;
+
+      float dist = sqrtf(distSq);
+
+      // If either is < MAX tier, we remove it
+      if (comets.tier[i] < MAX_COMET_TIER) {
+          indicesToRemove.push_back(i);
+          CreateSmallExplosion(comets.posX[i], comets.posY[i]);
+          score += 5;
+      }
+
+      if (comets.tier[j] < MAX_COMET_TIER) {
+          indicesToRemove.push_back(j);
+          CreateSmallExplosion(comets.posX[j], comets.posY[j]);
+          score += 5;
+      }
+
+      // If both are MAX tier, bounce
+      if (comets.tier[i] == MAX_COMET_TIER && comets.tier[j] == MAX_COMET_TIER) {
+          float nx = dx / dist;
+          float ny = dy / dist;
+          float dvx = comets.velX[i] - comets.velX[j];
+          float dvy = comets.velY[i] - comets.velY[j];
+          float dot = dvx * nx + dvy * ny;
+
+          if (dot <= 0) {
+              float impulse = dot;
+              comets.velX[i] -= impulse * nx;
+              comets.velY[i] -= impulse * ny;
+              comets.velX[j] += impulse * nx;
+              comets.velY[j] += impulse * ny;
+
+              float overlap = minDist - dist;
+              comets.posX[i] -= nx * overlap / 2.0f;
+              comets.posY[i] -= ny * overlap / 2.0f;
+              comets.posX[j] += nx * overlap / 2.0f;
+              comets.posY[j] += ny * overlap / 2.0f;
+
+              NoteGridMove(cometGrid, i, comets.posX[i], comets.posY[i]);
+              NoteGridMove(cometGrid, j, comets.posX[j], comets.posY[j]);
+          }
+      }
+
+      return true;
+  }
+
+  // Check for collisions between comets
+  void CheckCometCollisions() {
+      PROFILE_ZONE("comet collisions");
+      RunCollisionPass("comet", RunCometCollisions);
+  }
+
+  // Resolve comet contacts, removing the smaller tiers
+  void RunCometCollisions(bool useGrid) {
+      std::vector<int> indicesToRemove;
+
+      ForEachCandidatePair(comets, cometGrid, comets, true, useGrid,
+          [&](int i, int j) { return ResolveCometPair(i, j, indicesToRemove); });
+
+      // Removed comets keep colliding until the pass is over
+      for (auto index : indicesToRemove) {
+          KillEntity(comets, index);
+      }
+  }
+
+  // Bounce two big comets apart
+  bool ResolveBigCometPair(int i, int j) {
+      if (IsKilled(bigComets, i) || IsKilled(bigComets, j)) return false;
+
+      float dx = bigComets.posX[j] - bigComets.posX[i];
+      float dy = bigComets.posY[j] - bigComets.posY[i];
+      float distSq = dx*dx + dy*dy;
+      float minDist = bigComets.radius[i] + bigComets.radius[j];
+
+      if (distSq >= minDist * minDist || distSq <= 0) return false;
+
+      float dist = sqrtf(distSq);
+      float nx = dx / dist;
+      float ny = dy / dist;
+      float overlap = minDist - dist;
+
+      // Bounce them apart equally
+      bigComets.posX[i] -= nx * (overlap / 2.0f);
+      bigComets.posY[i] -= ny * (overlap / 2.0f);
+      bigComets.posX[j] += nx * (overlap / 2.0f);
+      bigComets.posY[j] += ny * (overlap / 2.0f);
+
+      NoteGridMove(bigCometGrid, i, bigComets.posX[i], bigComets.posY[i]);
+      NoteGridMove(bigCometGrid, j, bigComets.posX[j], bigComets.posY[j]);
+
+      // Adjust velocities (to simulate a bounce)
+      float impulse = (bigComets.velX[i] - bigComets.velX[j]) * nx + (bigComets.velY[i] - bigComets.velY[j]) * ny;
+      if (impulse < 0) {
+          bigComets.velX[i] -= impulse * nx;
+          bigComets.velY[i] -= impulse * ny;
+          bigComets.velX[j] += impulse * nx;
+          bigComets.velY[j] += impulse * ny;
+      }
+
+      return true;
+  }
+
+  // Bounce a normal comet off a big comet
+  bool ResolveBigCometVsComet(int i, int j) {
+      if (IsKilled(bigComets, i) || IsKilled(comets, j)) return false;
+
+      float dx = comets.posX[j] - bigComets.posX[i];
+      float dy = comets.posY[j] - bigComets.posY[i];
+      float distSq = dx*dx + dy*dy;
+      float minDist = bigComets.radius[i] + comets.radius[j];
+
+      if (distSq >= minDist * minDist || distSq <= 0) return false;
+
+      float dist = sqrtf(distSq);
+      float nx = dx / dist;
+      float ny = dy / dist;
+      float overlap = minDist - dist;
+
+      // Adjust positions so they bounce apart
+      comets.posX[j] += nx * (overlap / 2.0f);
+      comets.posY[j] += ny * (overlap / 2.0f);
+      bigComets.posX[i] -= nx * (overlap / 2.0f);
+      bigComets.posY[i] -= ny * (overlap / 2.0f);
+
+      NoteGridMove(cometGrid, j, comets.posX[j], comets.posY[j]);
+      NoteGridMove(bigCometGrid, i, bigComets.posX[i], bigComets.posY[i]);
+
+      // Bounce the normal comet more strongly
+      comets.velX[j] = -comets.velX[j] * 0.5f;
+      comets.velY[j] = -comets.velY[j] * 0.5f;
+
+      return true;
+  }
+
+  // Check for collisions between big comets
+  void CheckBigCometCollisions() {
+      PROFILE_ZONE("big comet collisions");
+      RunCollisionPass("big comet", RunBigCometCollisions);
+  }
+
+  // Bounce big comets off each other and off normal comets
+  void RunBigCometCollisions(bool useGrid) {
+      // Big Comets vs. Big Comets
+      ForEachCandidatePair(bigComets, bigCometGrid, bigComets, true, useGrid, ResolveBigCometPair);
+
+      // Big Comets vs. Normal Comets
+      ForEachCandidatePair(bigComets, cometGrid, comets, false, useGrid, ResolveBigCometVsComet);
+  }
+
+  // Spawn a power-up
+  EntityHandle SpawnPowerUp() {
+      Vector2 loc = GetSpawnLocation();
+
+      const int i = AddEntity(powerUps);
+      powerUps.posX[i] = loc.x;
+      powerUps.posY[i] = loc.y;
+      powerUps.velX[i] = RandomRange(-50.0f, 50.0f);
+      powerUps.velY[i] = RandomRange(-50.0f, 50.0f);
+      powerUps.lifetime[i] = 10.0f;
+      powerUps.radius[i] = POWERUP_RADIUS;
+
+      return GetHandle(powerUps.handles, i);
+  }
+
+  // Toggle music on/off
+  void ToggleMusic() {
+      musicEnabled = !musicEnabled;
+      soundEnabled = musicEnabled; // Link sound effects to music toggle
+
+      if (musicEnabled) {
+          // Resume music based on current game state
+          if (gameState == MENU || gameState == SETTINGS) {
+              StartMenuMusic();
+          } else if (gameState == PLAYING) {
+              StartGameplayMusic();
+          }
+      } else {
+          // Stop music
+          StopMusicStream(menuMusic);
+          StopMusicStream(gameplayMusic);
+      }
+  }
+
+  // Toggle all sounds
+  void ToggleAllSounds() {
+      soundEnabled = !soundEnabled;
+
+      if (!soundEnabled) {
+          // Turn off music
+          musicEnabled = false;
+          StopMusicStream(menuMusic);
+          StopMusicStream(gameplayMusic);
+      }
+  }
+
+  // Start menu music
+  void StartMenuMusic() {
+      StopMusicStream(gameplayMusic);
+
+      if (musicEnabled) {
+          PlayMusicStream(menuMusic);
+      }
+  }
+
+  // Start gameplay music
+  void StartGameplayMusic() {
+      StopMusicStream(menuMusic);
+
+      if (musicEnabled) {
+          PlayMusicStream(gameplayMusic);
+      }
+  }
+
+  // Reset the simulation to the start of a game
+  void ResetSimulation() {
+      ship.position = (Vector2){ SCREEN_WIDTH / 2.0f, SCREEN_HEIGHT / 2.0f };
       ship.velocity = (Vector2){ 0, 0 };
       ship.angle = 0;
+      ship.size = SHIP_SIZE;
       ship.hitPoints = 5;
       ship.hitFlashTimer = 0;
+      ship.thrusting = false;
+
+      ClearEntities(bullets);
+      sparks.clear();
+      ClearEntities(comets);
+      ClearEntities(bigComets);
+      explosionParticles.count = 0;
+      ClearEntities(powerUps);
+
+      lastBulletTime = 0;
+      cometSpawnTimer = 0;
+      bigCometSpawnTimer = 0;
+      powerUpSpawnTimer = 0;
+      score = 0;
+      gameTime = 0;
+      winTriggered = false;
+
+      // Spawn an initial comet
+      SpawnComet();
+  }
+
+  // Restart the game
+  void RestartGame() {
+      gameState = MENU;
+      StartMenuMusic();
+
+      ResetSimulation();
+      InitStarfield();
+  }
+
+  // Ask the frontend to play a sound
+  void QueueSound(SoundEvent sound) {
+      soundEvents.push_back(sound);
+  }
+
+  // Play the sounds the last update queued. The game-ending ones also stop the
+  // gameplay music, whether or not sound is on.
+  void PlayQueuedSounds() {
+      for (auto sound : soundEvents) {
+          if (sound == SOUND_VICTORY || sound == SOUND_DEFEAT) {
+              StopMusicStream(gameplayMusic);
+          }
+
+          if (!soundEnabled) continue;
+
+          switch (sound) {
+              case SOUND_BULLET: PlaySound(bulletSound); break;
+              case SOUND_HIT: PlaySound(hitSound); break;
+              case SOUND_EXPLOSION: PlaySound(explosionSound); break;
+              case SOUND_POWERUP: PlaySound(powerUpSound); break;
+              case SOUND_VICTORY: PlaySound(victorySound); break;
+              case SOUND_DEFEAT: PlaySound(defeatSound); break;
+          }
+      }
+      soundEvents.clear();
+  }
+
+  // Read the keyboard into this tick's input command
+  InputCommand ReadInput() {
+      InputCommand input = 0;
+      if (IsKeyDown(KEY_UP)) input |= INPUT_THRUST;
+      if (IsKeyDown(KEY_DOWN)) input |= INPUT_REVERSE;
+      if (IsKeyDown(KEY_SPACE)) input |= INPUT_BRAKE;
+      if (IsKeyDown(KEY_LEFT)) input |= INPUT_LEFT;
+      if (IsKeyDown(KEY_RIGHT)) input |= INPUT_RIGHT;
+      return input;
+  }
+
+  // Fixed input routine for headless runs: a four-second loop of turns, thrust
+  // and braking
+  InputCommand ScriptedInput(long tick) {
+      switch ((tick / 60) % 4) {
+          case 0: return INPUT_THRUST | INPUT_LEFT;
+          case 1: return INPUT_RIGHT;
+          case 2: return INPUT_REVERSE;
+          default: return INPUT_BRAKE | INPUT_LEFT;
+      }
+  }
+
+  // Headless bot: turn toward the nearest comet and hold it at mid range
+  InputCommand BotInput() {
+      int nearest = -1;
+      float nearestDistSq = 0;
+      for (int i = 0; i < EntityCount(comets); i++) {
+          float dx = comets.posX[i] - ship.position.x;
+          float dy = comets.posY[i] - ship.position.y;
+          float distSq = dx*dx + dy*dy;
+          if (nearest < 0 || distSq < nearestDistSq) {
+              nearest = i;
+              nearestDistSq = distSq;
+          }
+      }
+      if (nearest < 0) return INPUT_BRAKE;
+
+      InputCommand input = 0;
+      float target = atan2f(comets.posY[nearest] - ship.position.y, comets.posX[nearest] - ship.position.x);
+      float turn = remainderf(target - ship.angle, 2.0f * PI);
+      if (turn < -0.05f) input |= INPUT_LEFT;
+      if (turn > 0.05f) input |= INPUT_RIGHT;
+
+      float dist = sqrtf(nearestDistSq);
+      if (dist < 200.0f) input |= INPUT_REVERSE;
+      else if (dist > 400.0f) input |= INPUT_THRUST;
+      else input |= INPUT_BRAKE;
+
+      return input;
+  }
+
+  // FNV-1a over everything Update carries from tick to tick (see
+  // SimulationSnapshot), for comparing runs
+  uint32_t SimulationChecksum() {
+      uint32_t hash = 2166136261u;
+      auto mix = [&hash](const void* data, size_t size) {
+          const unsigned char* bytes = (const unsigned char*)data;
+          for (size_t i = 0; i < size; i++) {
+              hash = (hash ^ bytes[i]) * 16777619u;
+          }
+      };
+
+      auto mixColumns = [&mix](int count, std::initializer_list<const void*> columns, size_t size) {
+          mix(&count, sizeof(count));
+          for (const void* column : columns) {
+              mix(column, count * size);
+          }
+      };
+
+      mix(&gameState, sizeof(gameState));
+      mix(&ship.position, sizeof(ship.position));
+      mix(&ship.velocity, sizeof(ship.velocity));
+      mix(&ship.angle, sizeof(ship.angle));
+      mix(&ship.hitPoints, sizeof(ship.hitPoints));
+      mix(&ship.hitFlashTimer, sizeof(ship.hitFlashTimer));
+      mix(&score, sizeof(score));
+      mix(&winTriggered, sizeof(winTriggered));
+      mix(&gameTime, sizeof(gameTime));
+      mix(&lastBulletTime, sizeof(lastBulletTime));
+      mix(&cometSpawnTimer, sizeof(cometSpawnTimer));
+      mix(&bigCometSpawnTimer, sizeof(bigCometSpawnTimer));
+      mix(&powerUpSpawnTimer, sizeof(powerUpSpawnTimer));
+
+      mixColumns(EntityCount(comets), { comets.posX.data(), comets.posY.data(), comets.velX.data(), comets.velY.data(),
+                                        comets.radius.data(), comets.hitEffectTimer.data(), comets.slowEffectTimer.data(),
+                                        comets.indestructableTimer.data(), comets.trailTimer.data() }, sizeof(float));
+      mixColumns(EntityCount(comets), { comets.tier.data(), comets.hitPoints.data() }, sizeof(int));
+      mixColumns(EntityCount(bigComets), { bigComets.posX.data(), bigComets.posY.data(), bigComets.velX.data(),
+                                           bigComets.velY.data(), bigComets.radius.data() }, sizeof(float));
+      mixColumns(EntityCount(bullets), { bullets.posX.data(), bullets.posY.data(), bullets.velX.data(),
+                                         bullets.velY.data() }, sizeof(float));
+      mixColumns(EntityCount(powerUps), { powerUps.posX.data(), powerUps.posY.data(), powerUps.velX.data(),
+                                          powerUps.velY.data(), powerUps.lifetime.data() }, sizeof(float));
+      mixColumns(sparks.size(), { sparks.data() }, sizeof(Spark));
+
+      // 624 outputs of a copy pin down the generator's whole state
+      std::mt19937 state = *rng;
+      for (int i = 0; i < 624; i++) {
+          const uint32_t word = state();
+          mix(&word, sizeof(word));
+      }
+      return hash;
+  }
+
+  // Scatter count comets of random tiers over the screen, clear of the ship
+  void SpawnCrowd(int count) {
+      const float clearance = 150.0f;
+      for (int i = 0; i < count; i++) {
+          float x, y;
+          do {
+              x = RandomRange(0.0f, SCREEN_WIDTH);
+              y = RandomRange(0.0f, SCREEN_HEIGHT);
+          } while (fabsf(x - ship.position.x) < clearance && fabsf(y - ship.position.y) < clearance);
+          SpawnComet(RandomInt(1, MAX_COMET_TIER), x, y);
+      }
+  }
+
+  // Run the simulation without a window or audio device and report its speed.
+  // Options: --ticks N, --seed S, --dt SECONDS, --input bot|script|idle,
+  // --scalar (force the scalar kernels), --verify-broadphase, --replay FILE,
+  // --workers N (job pool size, none by default), --trace FILE (Chrome trace of the
+  // last ticks), --crowd N (start every game with N more comets of mixed tiers
+  // scattered around the ship, to stress the broad phase and the job pool).
+  // A game that ends is restarted, so every run lasts exactly N ticks. A replay
+  // supplies the seed, dt, ticks and input instead, and the run is audited
+  // against the score and checksum it recorded.
+  int RunHeadless(int argc, char** argv) {
+      long ticks = 36000;
+      uint32_t seed = 1;
+      float dt = 1.0f / 60.0f;
+      const char* inputMode = "bot";
+      const char* replayPath = nullptr;
+      const char* tracePath = nullptr;
+      int workerCount = 0;
+      int crowd = 0;
+      kernels = SelectKernels();
+      InitShapeCache();
+
+      for (int i = 1; i < argc; i++) {
+          const bool hasValue = i + 1 < argc;
+          if (!strcmp(argv[i], "--ticks") && hasValue) ticks = atol(argv[++i]);
+          else if (!strcmp(argv[i], "--seed") && hasValue) seed = strtoul(argv[++i], nullptr, 10);
+          else if (!strcmp(argv[i], "--dt") && hasValue) dt = strtof(argv[++i], nullptr);
+          else if (!strcmp(argv[i], "--input") && hasValue) inputMode = argv[++i];
+          else if (!strcmp(argv[i], "--scalar")) kernels = &scalarKernels;
+          else if (!strcmp(argv[i], "--verify-broadphase")) verifyBroadPhase = true;
+          else if (!strcmp(argv[i], "--replay") && hasValue) replayPath = argv[++i];
+          else if (!strcmp(argv[i], "--workers") && hasValue) workerCount = atoi(argv[++i]);
+          else if (!strcmp(argv[i], "--trace") && hasValue) tracePath = argv[++i];
+          else if (!strcmp(argv[i], "--crowd") && hasValue) crowd = atoi(argv[++i]);
+          else {
+              fprintf(stderr, "Unknown option %s\n", argv[i]);
+              return 2;
+          }
+      }
+      if (ticks < 0) {
+          fprintf(stderr, "Tick count %ld is negative\n", ticks);
+          return 2;
+      }
 
-      bullets.clear();
-      sparks.clear();
-      comets.clear();
-      bigComets.clear();
-      explosionParticles.clear();
-      powerUps.clear();
+      ReplayPlayback replay;
+      if (replayPath) {
+          if (!LoadReplay(replayPath, replay.header, replay.inputs)) return 2;
+          seed = replay.header.seed;
+          dt = replay.header.dt;
+          ticks = replay.inputs.size();
+          inputMode = "replay";
+          crowd = 0;
+      }
 
-      lastBulletTime = 0;
-      cometSpawnTimer = 0;
-      bigCometSpawnTimer = 0;
-      powerUpSpawnTimer = 0;
-      score = 0;
-      gameTime = 0;
-      winTriggered = false;
+      const bool bot = !strcmp(inputMode, "bot");
+      const bool script = !strcmp(inputMode, "script");
+      if (!replayPath && !bot && !script && strcmp(inputMode, "idle")) {
+          fprintf(stderr, "Unknown input mode %s\n", inputMode);
+          return 2;
+      }
 
-      // Spawn an initial comet
-      SpawnComet();
-      InitStarfield();
+      SeedRandom(seed);
+      ResetSimulation();
+      gameState = PLAYING;
+      SpawnCrowd(crowd);
+      NameProfileThread("main");
+      StartJobSystem(workerCount);
+
+      std::vector<float> tickTimes(ticks);
+      int games = 1;
+      int wins = 0;
+      long scoreTotal = 0;
+      double cometTotal = 0, bulletTotal = 0, particleTotal = 0;
+      int cometPeak = 0, bulletPeak = 0, particlePeak = 0, bigCometPeak = 0;
+
+      auto runStart = std::chrono::steady_clock::now();
+      for (long tick = 0; tick < ticks; tick++) {
+          InputCommand input = 0;
+          if (replayPath) input = replay.inputs[tick];
+          else if (bot) input = BotInput();
+          else if (script) input = ScriptedInput(tick);
+
+          auto start = std::chrono::steady_clock::now();
+          Update(dt, input);
+          tickTimes[tick] = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count();
+          soundEvents.clear();
+          ProfileFrameMark();
+
+          cometTotal += EntityCount(comets);
+          bulletTotal += EntityCount(bullets);
+          particleTotal += explosionParticles.count;
+          cometPeak = std::max(cometPeak, EntityCount(comets));
+          bulletPeak = std::max(bulletPeak, EntityCount(bullets));
+          particlePeak = std::max(particlePeak, explosionParticles.count);
+          bigCometPeak = std::max(bigCometPeak, EntityCount(bigComets));
+
+          if (gameState != PLAYING && tick + 1 < ticks && !replayPath) {
+              if (gameState == WIN) wins++;
+              scoreTotal += score;
+              games++;
+              ResetSimulation();
+              gameState = PLAYING;
+              SpawnCrowd(crowd);
+          }
+      }
+      const double runSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+
+      // The last game is never restarted, so count it here
+      if (gameState == WIN) wins++;
+      scoreTotal += score;
+
+      std::vector<float> sorted = tickTimes;
+      std::sort(sorted.begin(), sorted.end());
+      auto percentile = [&sorted](double q) { return sorted.empty() ? 0.0f : sorted[(size_t)(q * (sorted.size() - 1))]; };
+      const double n = std::max(1L, ticks);
+      const long slowestTick = std::max_element(tickTimes.begin(), tickTimes.end()) - tickTimes.begin();
+
+      printf("Headless: %ld ticks, dt %.6f, seed %u, input %s, kernels %s\n", ticks, dt, seed, inputMode, kernels->name);
+      printf("Ticks/sec: %.1f\n", ticks / runSeconds);
+      printf("Tick time (us): p50 %.1f, p99 %.1f, max %.1f at tick %ld\n", percentile(0.50), percentile(0.99), percentile(1.0), slowestTick);
+      printf("Games: %d (%d won), mean score %.1f\n", games, wins, (double)scoreTotal / games);
+      printf("Comets: mean %.1f, peak %d; big comets peak %d\n", cometTotal / n, cometPeak, bigCometPeak);
+      printf("Bullets: mean %.1f, peak %d; particles: mean %.1f, peak %d\n", bulletTotal / n, bulletPeak, particleTotal / n, particlePeak);
+      printf("Checksum: %08x\n", SimulationChecksum());
+      if (verifyBroadPhase) {
+          printf("Broad phase mismatches: %d; collision passes %.1f us/tick on the grid, %.1f us/tick brute force\n",
+                 broadPhaseMismatches, 1e6 * gridPassSeconds / n, 1e6 * brutePassSeconds / n);
+      }
+      PrintStageTimes(ticks);
+      StopJobSystem();
+      if (tracePath && DumpProfileTrace(tracePath, PROFILE_TRACE_FRAMES)) {
+          printf("Trace: last %d ticks written to %s\n", (int)std::min((long)PROFILE_TRACE_FRAMES, ticks), tracePath);
+      }
+
+      bool auditFailed = false;
+      if (replayPath && replay.header.tickCount == 0) {
+          printf("Replay audit: skipped, the recording was never closed\n");
+      } else if (replayPath) {
+          auditFailed = score != replay.header.finalScore || SimulationChecksum() != replay.header.checksum;
+          printf("Replay audit: score %d, recorded %d, checksum %08x, recorded %08x: %s\n", score, replay.header.finalScore,
+                 SimulationChecksum(), replay.header.checksum, auditFailed ? "MISMATCH" : "ok");
+      }
+
+      return broadPhaseMismatches > 0 || auditFailed ? 1 : 0;
   }
 
-  // Draw the normal comets
-  void DrawNormalComets() {
-      for (const auto& comet : comets) {
-          // Draw comet trail
-          if (!comet.trail.empty()) {
-              float maxAlpha = 0.1f;
-              for (size_t i = 0; i < comet.trail.size(); i++) {
-                  const auto& pos = comet.trail[i];
-                  float alpha = ((float)(i + 1) / comet.trail.size()) * maxAlpha;
+  // Start a fresh game from a new seed and record it
+  void StartNewGame() {
+      StopRecording();
+
+      const uint32_t seed = std::random_device{}();
+      SeedRandom(seed);
+      ResetSimulation();
+      gameState = PLAYING;
+      StartGameplayMusic();
+
+      char path[32];
+      snprintf(path, sizeof(path), "replay-%08x.scrp", seed);
+      StartRecording(path, seed, FIXED_DT);
+  }
+
+  // Open a replay file and write its header. Ticks go through a large stdio
+  // buffer, so play only touches the disk every few minutes of input.
+  bool StartRecording(const char* path, uint32_t seed, float dt) {
+      StopRecording();
+
+      recorder.file = fopen(path, "wb");
+      if (!recorder.file) {
+          TraceLog(LOG_WARNING, "Could not open %s for recording", path);
+          return false;
+      }
+      setvbuf(recorder.file, nullptr, _IOFBF, 1 << 16);
+
+      recorder.header = {};
+      memcpy(recorder.header.magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+      recorder.header.version = REPLAY_VERSION;
+      recorder.header.seed = seed;
+      recorder.header.dt = dt;
+      fwrite(&recorder.header, sizeof(recorder.header), 1, recorder.file);
+      return true;
+  }
+
+  // Append the input of the tick about to run
+  void RecordTick(InputCommand input) {
+      if (!recorder.file) return;
+
+      fputc(input, recorder.file);
+      recorder.header.tickCount++;
+  }
+
+  // Patch the run's totals into the header and close the file
+  void StopRecording() {
+      if (!recorder.file) return;
+
+      recorder.header.finalScore = score;
+      recorder.header.checksum = SimulationChecksum();
+      fseek(recorder.file, 0, SEEK_SET);
+      fwrite(&recorder.header, sizeof(recorder.header), 1, recorder.file);
+      fclose(recorder.file);
+      recorder.file = nullptr;
+  }
+
+  // Read a replay file. A recording that was never closed still loads, with
+  // as much input as reached the disk.
+  bool LoadReplay(const char* path, ReplayHeader& header, std::vector<InputCommand>& inputs) {
+      FILE* file = fopen(path, "rb");
+      if (!file) {
+          TraceLog(LOG_WARNING, "Could not open replay %s", path);
+          return false;
+      }
+
+      bool ok = fread(&header, sizeof(header), 1, file) == 1 && !memcmp(header.magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+      if (!ok) {
+          TraceLog(LOG_WARNING, "%s is not a replay", path);
+      } else if (header.version != REPLAY_VERSION) {
+          TraceLog(LOG_WARNING, "%s is a version %u replay, this build plays version %u", path, header.version, REPLAY_VERSION);
+          ok = false;
+      }
+
+      if (ok) {
+          InputCommand buffer[4096];
+          size_t read;
+          inputs.clear();
+          while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+              inputs.insert(inputs.end(), buffer, buffer + read);
+          }
+
+          if (header.tickCount == 0) {
+              TraceLog(LOG_WARNING, "%s was never closed, playing its %d recorded ticks", path, (int)inputs.size());
+          } else if (inputs.size() < header.tickCount) {
+              TraceLog(LOG_WARNING, "%s is truncated", path);
+              ok = false;
+          } else {
+              inputs.resize(header.tickCount);
+          }
+      }
+
+      fclose(file);
+      return ok;
+  }
+
+  // Copy the simulation state out
+  void CaptureSnapshot(SimulationSnapshot& snapshot) {
+      snapshot.gameState = gameState;
+      snapshot.ship = ship;
+      snapshot.bullets = bullets;
+      snapshot.sparks = sparks;
+      snapshot.comets = comets;
+      snapshot.bigComets = bigComets;
+      snapshot.powerUps = powerUps;
+      snapshot.gameTime = gameTime;
+      snapshot.lastBulletTime = lastBulletTime;
+      snapshot.cometSpawnTimer = cometSpawnTimer;
+      snapshot.bigCometSpawnTimer = bigCometSpawnTimer;
+      snapshot.powerUpSpawnTimer = powerUpSpawnTimer;
+      snapshot.score = score;
+      snapshot.winTriggered = winTriggered;
+      snapshot.rng = *rng;
+  }
+
+  // Put a captured state back. Live particles belong to another moment, so
+  // they are dropped.
+  void RestoreSnapshot(const SimulationSnapshot& snapshot) {
+      gameState = snapshot.gameState;
+      ship = snapshot.ship;
+      bullets = snapshot.bullets;
+      sparks = snapshot.sparks;
+      comets = snapshot.comets;
+      bigComets = snapshot.bigComets;
+      powerUps = snapshot.powerUps;
+      gameTime = snapshot.gameTime;
+      lastBulletTime = snapshot.lastBulletTime;
+      cometSpawnTimer = snapshot.cometSpawnTimer;
+      bigCometSpawnTimer = snapshot.bigCometSpawnTimer;
+      powerUpSpawnTimer = snapshot.powerUpSpawnTimer;
+      score = snapshot.score;
+      winTriggered = snapshot.winTriggered;
+      *rng = snapshot.rng;
+
+      explosionParticles.count = 0;
+      soundEvents.clear();
+  }
+
+  // Start a replay over from its first tick
+  void BeginPlayback(ReplayPlayback& playback) {
+      SeedRandom(playback.header.seed);
+      ResetSimulation();
+      gameState = PLAYING;
+
+      playback.tick = 0;
+      playback.snapshots.resize(1);
+      CaptureSnapshot(playback.snapshots[0]);
+  }
+
+  // Re-simulate up to targetTick, taking any snapshot not yet taken on the way
+  void AdvancePlayback(ReplayPlayback& playback, long targetTick) {
+      targetTick = std::min(targetTick, (long)playback.inputs.size());
+      while (playback.tick < targetTick) {
+          Update(playback.header.dt, playback.inputs[playback.tick]);
+          soundEvents.clear();
+          playback.tick++;
+
+          if (playback.tick % REPLAY_SNAPSHOT_INTERVAL == 0 &&
+              (long)playback.snapshots.size() == playback.tick / REPLAY_SNAPSHOT_INTERVAL) {
+              playback.snapshots.emplace_back();
+              CaptureSnapshot(playback.snapshots.back());
+          }
+      }
+  }
+
+  // Jump to targetTick: restore the last snapshot at or before it, unless the
+  // current tick is closer, and re-simulate the rest of the way
+  void SeekPlayback(ReplayPlayback& playback, long targetTick) {
+      targetTick = std::max(0L, std::min(targetTick, (long)playback.inputs.size()));
+      const long nearest = std::min(targetTick / REPLAY_SNAPSHOT_INTERVAL, (long)playback.snapshots.size() - 1);
+      if (targetTick < playback.tick || nearest * REPLAY_SNAPSHOT_INTERVAL > playback.tick) {
+          RestoreSnapshot(playback.snapshots[nearest]);
+          playback.tick = nearest * REPLAY_SNAPSHOT_INTERVAL;
+      }
+      AdvancePlayback(playback, targetTick);
+  }
+
+  // Draw the playback position and, once the end is reached, the audit result
+  void DrawPlaybackOverlay(const ReplayPlayback& playback, int ticksPerFrame, bool paused) {
+      const float dt = playback.header.dt;
+      const long total = playback.inputs.size();
+
+      char speedText[24];
+      if (paused) snprintf(speedText, sizeof(speedText), "paused");
+      else snprintf(speedText, sizeof(speedText), "%d ticks/frame", ticksPerFrame);
+
+      char positionText[96];
+      snprintf(positionText, sizeof(positionText), "Replay %.1fs / %.1fs  %s  %d FPS", playback.tick * dt, total * dt, speedText, GetFPS());
+      DrawText(positionText, 10, SCREEN_HEIGHT - 30, 20, LIGHTGRAY);
+      DrawText("SPACE pause  UP/DOWN speed  LEFT/RIGHT seek  HOME/END", 10, SCREEN_HEIGHT - 55, 20, GRAY);
+
+      if (playback.tick == total && playback.header.tickCount > 0) {
+          const bool verified = score == playback.header.finalScore && SimulationChecksum() == playback.header.checksum;
+          char auditText[48];
+          snprintf(auditText, sizeof(auditText), "Recorded score %d: %s", playback.header.finalScore, verified ? "verified" : "MISMATCH");
+          DrawText(auditText, 10, SCREEN_HEIGHT - 80, 20, verified ? GREEN : RED);
+      }
+  }
+
+  // Watch a replay with the frame rate uncapped. SPACE pauses, UP/DOWN double
+  // or halve the ticks run per frame, LEFT/RIGHT seek ten seconds and HOME/END
+  // jump to either end.
+  int RunReplayViewer(const char* path) {
+      ReplayPlayback playback;
+      if (!LoadReplay(path, playback.header, playback.inputs)) return 1;
 
-                  DrawCircle(pos.x, pos.y, comet.radius, ColorAlpha(SKYBLUE, alpha));
+      SetTargetFPS(0);
+      BeginPlayback(playback);
+
+      int ticksPerFrame = 1;
+      bool paused = false;
+      while (!WindowShouldClose()) {
+          if (IsKeyPressed(KEY_SPACE)) paused = !paused;
+          if (IsKeyPressed(KEY_UP)) ticksPerFrame = std::min(ticksPerFrame * 2, 1024);
+          if (IsKeyPressed(KEY_DOWN)) ticksPerFrame = std::max(ticksPerFrame / 2, 1);
+          if (IsKeyPressed(KEY_LEFT)) SeekPlayback(playback, playback.tick - REPLAY_SEEK_STEP);
+          if (IsKeyPressed(KEY_RIGHT)) SeekPlayback(playback, playback.tick + REPLAY_SEEK_STEP);
+          if (IsKeyPressed(KEY_HOME)) SeekPlayback(playback, 0);
+          if (IsKeyPressed(KEY_END)) SeekPlayback(playback, playback.inputs.size());
+
+          if (!paused) AdvancePlayback(playback, playback.tick + ticksPerFrame);
+          UpdateStarfield(GetFrameTime());
+
+          PublishFrame(frontFrame);
+          RefreshBackground();
+          BeginDrawing();
+          ClearBackground(BLACK);
+          Draw(frontFrame);
+          DrawPlaybackOverlay(playback, ticksPerFrame, paused);
+          DrawProfilerHud(frontFrame);
+          {
+              PROFILE_ZONE("end drawing");
+              EndDrawing();
+          }
+
+          ProfileFrameMark();
+          HandleProfilerKeys();
+      }
+
+      return 0;
+  }
+
+  // Start the job pool. With no workers, ParallelFor runs everything inline.
+  void StartJobSystem(int workerCount) {
+      workerCount = std::max(0, std::min(MAX_WORKERS, workerCount));
+      jobSystem.queues = std::make_unique<JobQueue[]>(std::max(1, workerCount));
+      jobSystem.queueCount = workerCount;
+      jobSystem.quit = false;
+      for (int i = 0; i < workerCount; i++) {
+          jobSystem.workers.emplace_back(WorkerLoop, i);
+      }
+  }
+
+  // Finish the workers. Nothing may be running ParallelFor.
+  void StopJobSystem() {
+      {
+          std::lock_guard<std::mutex> lock(jobSystem.sleepMutex);
+          jobSystem.quit = true;
+      }
+      jobSystem.wake.notify_all();
+
+      for (auto& worker : jobSystem.workers) {
+          worker.join();
+      }
+      jobSystem.workers.clear();
+      jobSystem.queueCount = 0;
+  }
+
+  // Run jobs until told to quit, sleeping whenever every queue is empty
+  void WorkerLoop(int index) {
+      char name[24];
+      snprintf(name, sizeof(name), "worker %d", index);
+      NameProfileThread(name);
+
+      for (;;) {
+          if (RunOneJob(index)) continue;
+
+          std::unique_lock<std::mutex> lock(jobSystem.sleepMutex);
+          jobSystem.wake.wait(lock, [] { return jobSystem.quit || jobSystem.queued.load() > 0; });
+          if (jobSystem.quit) return;
+      }
+  }
+
+  // Add a job to the back of a worker's queue. Returns false if it is full.
+  bool PushJob(int index, const Job& job) {
+      JobQueue& queue = jobSystem.queues[index];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.count == JOB_QUEUE_SIZE) return false;
+
+      queue.jobs[(queue.head + queue.count) % JOB_QUEUE_SIZE] = job;
+      queue.count++;
+      jobSystem.queued++;
+      return true;
+  }
+
+  // Run one job: the newest in queue home, or else the oldest in any other.
+  // home is -1 for threads outside the pool. Returns false if none was queued.
+  bool RunOneJob(int home) {
+      for (int k = 0; k < jobSystem.queueCount; k++) {
+          const int index = (std::max(0, home) + k) % jobSystem.queueCount;
+          JobQueue& queue = jobSystem.queues[index];
+
+          Job job;
+          {
+              std::lock_guard<std::mutex> lock(queue.mutex);
+              if (queue.count == 0) continue;
+
+              queue.count--;
+              if (index == home) {
+                  job = queue.jobs[(queue.head + queue.count) % JOB_QUEUE_SIZE];
+              } else {
+                  job = queue.jobs[queue.head];
+                  queue.head = (queue.head + 1) % JOB_QUEUE_SIZE;
               }
           }
+          jobSystem.queued--;
+
+          // The range's owner may return as soon as pending drops, so the job
+          // is not touched after that
+          ProfileZone zone("job");
+          job.run(job.body, job.begin, job.end);
+          zone.End();
+          job.pending->fetch_sub(1);
+          return true;
+      }
+      return false;
+  }
 
-          // Draw comet body with shape
-          if (!comet.shape.empty()) {
-              // Calculate all points first
-              std::vector<Vector2> points;
-              points.reserve(comet.shape.size());
+  // Wake sleeping workers after jobs were queued
+  void WakeWorkers() {
+      {
+          std::lock_guard<std::mutex> lock(jobSystem.sleepMutex);
+      }
+      jobSystem.wake.notify_all();
+  }
 
-              for (const auto& v : comet.shape) {
-                  float factor = v.factor;
-                  if (comet.morph) {
-                      const float rotSpeed = comet.rotationSpeed;
-                      factor += 0.1f * sin(gameTime * v.frequency * rotSpeed + v.phase);
-                  }
+  // Call body(begin, end) over slices of at least grain elements covering
+  // [0, count), spread over the job pool, and return once all are done. Slices
+  // must not touch each other's elements. Small ranges run inline on the calling
+  // thread.
+  template <typename Body>
+  void ParallelFor(int count, int grain, Body body) {
+      const int maxSlices = 4 * (jobSystem.queueCount + 1);
+      int slices = std::min((count + grain - 1) / grain, maxSlices);
+      if (slices <= 1 || jobSystem.queueCount == 0) {
+          if (count > 0) body(0, count);
+          return;
+      }
+
+      // Round slices to whole AVX2 registers
+      const int sliceSize = ((count + slices - 1) / slices + 7) & ~7;
+      slices = (count + sliceSize - 1) / sliceSize;
+
+      std::atomic<int> pending(slices);
+      auto run = [](void* context, int begin, int end) { (*(Body*)context)(begin, end); };
+
+      // Deal out every slice but the first, which this thread takes
+      for (int k = 1; k < slices; k++) {
+          const Job job = { run, &body, k * sliceSize, std::min(count, (k + 1) * sliceSize), &pending };
+          if (!PushJob(k % jobSystem.queueCount, job)) {
+              body(job.begin, job.end);
+              pending--;
+          }
+      }
+      WakeWorkers();
+
+      body(0, std::min(count, sliceSize));
+      pending--;
+
+      // Help with whatever is still queued until every slice is done
+      while (pending.load() > 0) {
+          if (!RunOneJob(-1)) std::this_thread::yield();
+      }
+  }
+
+  StageTimer::StageTimer(PipelineStage stage) : stage(stage), zone(STAGE_NAMES[stage]) {
+  }
+
+  StageTimer::~StageTimer() {
+      stageTimes.seconds[stage] += (ProfileNow() - zone.start) * 1e-9;
+      stageTimes.samples[stage]++;
+  }
+
+  // Print the mean time of every stage that ran, per call and per frame
+  void PrintStageTimes(long frames) {
+      printf("Stage timings over %ld frames, %d workers:\n", frames, jobSystem.queueCount);
+      for (int i = 0; i < STAGE_COUNT; i++) {
+          if (stageTimes.samples[i] == 0) continue;
+
+          printf("  %-12s %8.1f us/call %8.1f us/frame\n", STAGE_NAMES[i],
+                 1e6 * stageTimes.seconds[i] / stageTimes.samples[i], 1e6 * stageTimes.seconds[i] / std::max(1L, frames));
+      }
+  }
+
+  // Count every heap allocation, for the HUD's allocations per frame. The
+  // replacements stay out of line: once inlined, GCC pairs the std::free below with
+  // the caller's operator new and warns about a mismatched deallocation.
+  __attribute__((noinline)) void* operator new(std::size_t size) {
+      allocationCount.fetch_add(1, std::memory_order_relaxed);
+      if (void* p = std::malloc(size ? size : 1)) return p;
+      throw std::bad_alloc();
+  }
+
+  __attribute__((noinline)) void operator delete(void* p) noexcept {
+      std::free(p);
+  }
+
+  __attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept {
+      std::free(p);
+  }
+
+  // Nanoseconds since the profiler's epoch
+  int64_t ProfileNow() {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profileEpoch).count();
+  }
+
+  ProfileZone::ProfileZone(const char* name) : name(name), start(ProfileNow()), open(true) {
+  }
+
+  ProfileZone::~ProfileZone() {
+      End();
+  }
+
+  // Close the zone before the end of its scope
+  void ProfileZone::End() {
+      if (!open) return;
 
-                  float x = comet.position.x + comet.radius * factor * cos(v.angle);
-                  float y = comet.position.y + comet.radius * factor * sin(v.angle);
-                  points.push_back((Vector2){x, y});
+      open = false;
+      RecordProfileEvent(name, start, ProfileNow());
+  }
+
+  // This thread's event ring, registered on first use
+  ProfileThread* CurrentProfileThread() {
+      if (!profileThread) {
+          std::lock_guard<std::mutex> lock(profiler.threadsMutex);
+          profiler.threads.push_back(std::make_unique<ProfileThread>());
+          profileThread = profiler.threads.back().get();
+          profileThread->id = profiler.threads.size() - 1;
+          snprintf(profileThread->name, sizeof(profileThread->name), "thread %d", profileThread->id);
+      }
+      return profileThread;
+  }
+
+  // Label this thread in traces
+  void NameProfileThread(const char* name) {
+      snprintf(CurrentProfileThread()->name, sizeof(profileThread->name), "%s", name);
+  }
+
+  void RecordProfileEvent(const char* name, int64_t start, int64_t end) {
+      ProfileThread* thread = CurrentProfileThread();
+      const uint64_t index = thread->written.load(std::memory_order_relaxed);
+      thread->events[index % PROFILE_RING_SIZE] = (ProfileEvent){ name, start, end };
+      thread->written.store(index + 1, std::memory_order_release);
+  }
+
+  // Add a zone's time to the HUD window, giving new zones a slot while any are free
+  void AddZoneTime(const char* name, double ms) {
+      for (int i = 0; i < profiler.zoneCount; i++) {
+          ProfileZoneStats& zone = profiler.zones[i];
+          if (zone.name == name || !strcmp(zone.name, name)) {
+              zone.windowMs += ms;
+              zone.windowCalls++;
+              return;
+          }
+      }
+
+      if (profiler.zoneCount == PROFILE_MAX_ZONES) return;
+      profiler.zones[profiler.zoneCount++] = (ProfileZoneStats){ name, ms, 1, 0.0f, 0.0f };
+  }
+
+  // End a frame: note when for trace dumps, and add the zones that ended
+  // during it, on any thread, to the HUD window. Call from one thread only.
+  void ProfileFrameMark() {
+      const int64_t now = ProfileNow();
+      const int64_t previous = profiler.frames > 0 ? profiler.frameMarks[(profiler.frames - 1) % (PROFILE_TRACE_FRAMES + 1)] : 0;
+      profiler.frameMarks[profiler.frames % (PROFILE_TRACE_FRAMES + 1)] = now;
+      profiler.frames++;
+
+      {
+          std::lock_guard<std::mutex> lock(profiler.threadsMutex);
+          for (auto& thread : profiler.threads) {
+              const int64_t written = thread->written.load(std::memory_order_acquire);
+              const int64_t oldest = std::max<int64_t>(0, written - PROFILE_RING_SIZE / 2);
+              for (int64_t i = written - 1; i >= oldest; i--) {
+                  const ProfileEvent& event = thread->events[i % PROFILE_RING_SIZE];
+                  if (event.end <= previous) break;
+                  if (event.end <= now) AddZoneTime(event.name, (event.end - event.start) * 1e-6);
               }
+          }
+      }
 
-              // Draw filled polygon
-              DrawTriangleFan(points.data(), points.size(), ColorAlpha(comet.color, 0.8f));
+      const long allocations = allocationCount.load(std::memory_order_relaxed);
+      profiler.windowAllocations += allocations - profiler.allocationsAtMark;
+      profiler.allocationsAtMark = allocations;
+      profiler.windowFrameMs += (now - previous) * 1e-6;
+      profiler.windowFrames++;
+
+      // Publish the window's per-frame means and start the next one
+      if (profiler.windowFrames == PROFILE_HUD_FRAMES) {
+          for (int i = 0; i < profiler.zoneCount; i++) {
+              ProfileZoneStats& zone = profiler.zones[i];
+              zone.ms = zone.windowMs / PROFILE_HUD_FRAMES;
+              zone.calls = (float)zone.windowCalls / PROFILE_HUD_FRAMES;
+              zone.windowMs = 0;
+              zone.windowCalls = 0;
+          }
+          profiler.frameMs = profiler.windowFrameMs / PROFILE_HUD_FRAMES;
+          profiler.allocationsPerFrame = (float)profiler.windowAllocations / PROFILE_HUD_FRAMES;
+          profiler.windowFrameMs = 0;
+          profiler.windowAllocations = 0;
+          profiler.windowFrames = 0;
+      }
+  }
 
-              // Draw outline
-              DrawPolyLines(points.data(), points.size(), true, 2.0f, comet.color);
-          } else {
-              // Fallback to circle if no shape
-              DrawCircle(comet.position.x, comet.position.y, comet.radius, ColorAlpha(comet.color, 0.8f));
-              DrawCircleLines(comet.position.x, comet.position.y, comet.radius, comet.color);
+  // Write the zones of the last frames, on every thread, as Chrome trace JSON
+  // (chrome://tracing or Perfetto). Frame ends are marked as instant events.
+  bool DumpProfileTrace(const char* path, int frames) {
+      FILE* file = fopen(path, "w");
+      if (!file) {
+          TraceLog(LOG_WARNING, "Could not open %s for the trace", path);
+          return false;
+      }
+
+      frames = (int)std::min({ (long)frames, profiler.frames, (long)PROFILE_TRACE_FRAMES });
+      const long first = profiler.frames - frames;
+      const int64_t since = first > 0 ? profiler.frameMarks[(first - 1) % (PROFILE_TRACE_FRAMES + 1)] : 0;
+
+      fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+      const char* separator = "";
+      for (long k = first; k < profiler.frames; k++) {
+          fprintf(file, "%s{\"name\":\"frame %ld\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,\"tid\":0}", separator, k,
+                  profiler.frameMarks[k % (PROFILE_TRACE_FRAMES + 1)] * 1e-3);
+          separator = ",\n";
+      }
+
+      std::lock_guard<std::mutex> lock(profiler.threadsMutex);
+      for (auto& thread : profiler.threads) {
+          fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", separator,
+                  thread->id, thread->name);
+          separator = ",\n";
+
+          const int64_t written = thread->written.load(std::memory_order_acquire);
+          for (int64_t i = std::max<int64_t>(0, written - PROFILE_RING_SIZE / 2); i < written; i++) {
+              const ProfileEvent& event = thread->events[i % PROFILE_RING_SIZE];
+              if (event.end <= since) continue;
+
+              fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}", event.name,
+                      event.start * 1e-3, (event.end - event.start) * 1e-3, thread->id);
           }
       }
+      fprintf(file, "\n]}\n");
+      fclose(file);
+      return true;
   }
 
-  // Draw the big comets
-  void DrawBigComets() {
-      for (const auto& bc : bigComets) {
-          // Draw big comet with shape
-          if (!bc.shape.empty()) {
-              // Calculate all points first
-              std::vector<Vector2> points;
-              points.reserve(bc.shape.size());
+  // F3 toggles the profiler HUD; F4 writes a trace of the last
+  // PROFILE_TRACE_FRAMES frames
+  void HandleProfilerKeys() {
+      if (IsKeyPressed(KEY_F3)) {
+          profiler.hudVisible = !profiler.hudVisible;
+      }
 
-              for (const auto& v : bc.shape) {
-                  float factor = v.factor;
-                  if (bc.morph) {
-                      const float rotSpeed = bc.rotationSpeed;
-                      factor += 0.1f * sin(gameTime * v.frequency * rotSpeed + v.phase);
-                  }
+      if (IsKeyPressed(KEY_F4)) {
+          char path[48];
+          snprintf(path, sizeof(path), "comets-trace-%ld.json", profiler.frames);
+          if (DumpProfileTrace(path, PROFILE_TRACE_FRAMES)) {
+              TraceLog(LOG_INFO, "Wrote the last %d frames to %s", PROFILE_TRACE_FRAMES, path);
+          }
+      }
+  }
+
+  // Start the simulation thread, idle until RunTicksAsync
+  void StartSimulationThread() {
+      simulationThread.quit = false;
+      simulationThread.busy = false;
+      simulationThread.thread = std::thread(SimulationThreadLoop);
+  }
+
+  // Finish the simulation thread after any ticks it is running
+  void StopSimulationThread() {
+      {
+          std::lock_guard<std::mutex> lock(simulationThread.mutex);
+          simulationThread.quit = true;
+      }
+      simulationThread.changed.notify_all();
+      simulationThread.thread.join();
+  }
+
+  // Run each batch of ticks handed over, recording their input
+  void SimulationThreadLoop() {
+      NameProfileThread("simulation");
+
+      std::unique_lock<std::mutex> lock(simulationThread.mutex);
+      for (;;) {
+          simulationThread.changed.wait(lock, [] { return simulationThread.quit || simulationThread.busy; });
+          if (simulationThread.quit) return;
+
+          const int ticks = simulationThread.ticks;
+          const InputCommand input = simulationThread.input;
+          lock.unlock();
+
+          for (int k = 0; k < ticks; k++) {
+              if (gameState == PLAYING) RecordTick(input);
+              Update(FIXED_DT, input);
+          }
+
+          lock.lock();
+          simulationThread.busy = false;
+          simulationThread.changed.notify_all();
+      }
+  }
+
+  // Start ticks on the simulation thread. Until WaitForTicks returns, the
+  // simulation state belongs to that thread.
+  void RunTicksAsync(int ticks, InputCommand input) {
+      {
+          std::lock_guard<std::mutex> lock(simulationThread.mutex);
+          simulationThread.ticks = ticks;
+          simulationThread.input = input;
+          simulationThread.busy = true;
+      }
+      simulationThread.changed.notify_all();
+  }
+
+  // Block until the ticks last started are done
+  void WaitForTicks() {
+      std::unique_lock<std::mutex> lock(simulationThread.mutex);
+      simulationThread.changed.wait(lock, [] { return !simulationThread.busy; });
+  }
+
+  // Copy the live particles, leaving the rest of the pool alone
+  void CopyParticles(ParticleStore& dst, const ParticleStore& src) {
+      const size_t bytes = src.count * sizeof(float);
+      memcpy(dst.posX, src.posX, bytes);
+      memcpy(dst.posY, src.posY, bytes);
+      memcpy(dst.velX, src.velX, bytes);
+      memcpy(dst.velY, src.velY, bytes);
+      memcpy(dst.lifetime, src.lifetime, bytes);
+      memcpy(dst.size, src.size, bytes);
+      memcpy(dst.color, src.color, src.count * sizeof(Color));
+      dst.count = src.count;
+      dst.recycle = src.recycle;
+  }
+
+  // Copy the latest tick out for drawing. Only call while no ticks are running.
+  void PublishFrame(FrameSnapshot& frame) {
+      StageTimer timer(STAGE_PUBLISH);
+      frame.gameState = gameState;
+      frame.ship = ship;
+      frame.sparks = sparks;
+      frame.bullets = bullets;
+      frame.comets = comets;
+      frame.bigComets = bigComets;
+      frame.powerUps = powerUps;
+      CopyParticles(frame.particles, explosionParticles);
+      frame.gameTime = gameTime;
+      frame.score = score;
+  }
+
+  // Emit a comet's fill and outline into the open RL_TRIANGLES batch. dist[k]
+  // is how far outline point k lies from the center; the outline is a band
+  // outlineWidth wide around it. Each triangle lists its vertices in the order
+  // raylib's own fans use, so none are culled.
+  void EmitCometPolygon(float cx, float cy, const CometShapePoint* shape, const float* dist, int segments, Color fill,
+                        Color outline, float outlineWidth) {
+      const float half = outlineWidth * 0.5f;
+
+      rlColor4ub(fill.r, fill.g, fill.b, fill.a);
+      for (int k = 0; k < segments; k++) {
+          const CometShapePoint& a = shape[k];
+          const CometShapePoint& b = shape[(k + 1) % segments];
+          const float da = dist[k];
+          const float db = dist[(k + 1) % segments];
+
+          rlVertex2f(cx, cy);
+          rlVertex2f(cx + db * b.cosAngle, cy + db * b.sinAngle);
+          rlVertex2f(cx + da * a.cosAngle, cy + da * a.sinAngle);
+      }
+
+      rlColor4ub(outline.r, outline.g, outline.b, outline.a);
+      for (int k = 0; k < segments; k++) {
+          const CometShapePoint& a = shape[k];
+          const CometShapePoint& b = shape[(k + 1) % segments];
+          const float innerA = dist[k] - half;
+          const float outerA = dist[k] + half;
+          const float innerB = dist[(k + 1) % segments] - half;
+          const float outerB = dist[(k + 1) % segments] + half;
+
+          rlVertex2f(cx + innerA * a.cosAngle, cy + innerA * a.sinAngle);
+          rlVertex2f(cx + outerB * b.cosAngle, cy + outerB * b.sinAngle);
+          rlVertex2f(cx + outerA * a.cosAngle, cy + outerA * a.sinAngle);
+
+          rlVertex2f(cx + innerA * a.cosAngle, cy + innerA * a.sinAngle);
+          rlVertex2f(cx + innerB * b.cosAngle, cy + innerB * b.sinAngle);
+          rlVertex2f(cx + outerB * b.cosAngle, cy + outerB * b.sinAngle);
+      }
+  }
+
+  // Draw the normal comets, trails and all, as one batch of triangles. A
+  // comet's vertices go straight into rlgl's vertex buffer, flushed whenever
+  // the next comet would overflow it.
+  void DrawNormalComets(const CometStore& comets, float gameTime) {
+      PROFILE_ZONE("comets");
+
+      const int vertsPerComet = 3 * TRAIL_SEGMENTS * COMET_TRAIL_LENGTH + 9 * COMET_SEGMENTS;
+
+      rlSetTexture(0);
+      rlBegin(RL_TRIANGLES);
+      for (int i = 0; i < EntityCount(comets); i++) {
+          const float cx = comets.posX[i];
+          const float cy = comets.posY[i];
+          const float radius = comets.radius[i];
+          const Color color = comets.color[i];
+          rlCheckRenderBatchLimit(vertsPerComet);
+
+          // Draw comet trail
+          const CometTrail& trail = comets.trail[i];
+          float maxAlpha = 0.1f;
+          for (int k = 0; k < trail.count; k++) {
+              const auto& pos = trail.points[k];
+              float alpha = ((float)(k + 1) / trail.count) * maxAlpha;
+
+              const Color trailColor = ColorAlpha(SKYBLUE, alpha);
+              rlColor4ub(trailColor.r, trailColor.g, trailColor.b, trailColor.a);
+              for (int s = 0; s < TRAIL_SEGMENTS; s++) {
+                  rlVertex2f(pos.x, pos.y);
+                  rlVertex2f(pos.x + radius * trailCircle[s + 1].x, pos.y + radius * trailCircle[s + 1].y);
+                  rlVertex2f(pos.x + radius * trailCircle[s].x, pos.y + radius * trailCircle[s].y);
+              }
+          }
 
-                  float x = bc.position.x + bc.radius * factor * cos(v.angle);
-                  float y = bc.position.y + bc.radius * factor * sin(v.angle);
-                  points.push_back((Vector2){x, y});
+          // Draw comet body from its shape template
+          const CometShapePoint* shape = cometShapes[comets.shapeId[i]].points;
+          float dist[COMET_SEGMENTS];
+          for (int k = 0; k < COMET_SEGMENTS; k++) {
+              const CometShapePoint& v = shape[k];
+              float factor = v.factor;
+              if (comets.morph[i]) {
+                  const float rotSpeed = comets.rotationSpeed[i];
+                  factor += 0.1f * LookupSin(gameTime * v.frequency * rotSpeed + v.phase);
               }
+              dist[k] = radius * factor;
+          }
 
-              // Draw filled polygon with texture
-              DrawTriangleFan(points.data(), points.size(), bc.color);
+          EmitCometPolygon(cx, cy, shape, dist, COMET_SEGMENTS, ColorAlpha(color, 0.8f), color, 2.0f);
+      }
+      rlEnd();
+  }
 
-              // Draw outline
-              DrawPolyLines(points.data(), points.size(), true, 1.5f, ColorAlpha((Color){50, 30, 20, 255}, 0.3f));
-          } else {
-              // Fallback to circle if no shape
-              DrawCircle(bc.position.x, bc.position.y, bc.radius, bc.color);
-              DrawCircleLines(bc.position.x, bc.position.y, bc.radius, ColorAlpha((Color){50, 30, 20, 255}, 0.3f));
+  // Draw the big comets as one batch of triangles
+  void DrawBigComets(const BigCometStore& bigComets, float gameTime) {
+      PROFILE_ZONE("big comets");
+
+      const int vertsPerComet = 9 * BIG_COMET_SEGMENTS;
+      const Color outline = ColorAlpha((Color){50, 30, 20, 255}, 0.3f);
+
+      rlSetTexture(0);
+      rlBegin(RL_TRIANGLES);
+      for (int i = 0; i < EntityCount(bigComets); i++) {
+          const float radius = bigComets.radius[i];
+          rlCheckRenderBatchLimit(vertsPerComet);
+
+          const CometShapePoint* shape = bigCometShapes[bigComets.shapeId[i]].points;
+          float dist[BIG_COMET_SEGMENTS];
+          for (int k = 0; k < BIG_COMET_SEGMENTS; k++) {
+              const CometShapePoint& v = shape[k];
+              float factor = v.factor;
+              if (bigComets.morph[i]) {
+                  const float rotSpeed = bigComets.rotationSpeed[i];
+                  factor += 0.1f * LookupSin(gameTime * v.frequency * rotSpeed + v.phase);
+              }
+              dist[k] = radius * factor;
           }
+
+          EmitCometPolygon(bigComets.posX[i], bigComets.posY[i], shape, dist, BIG_COMET_SEGMENTS, bigComets.color[i], outline,
+                           1.5f);
       }
+      rlEnd();
   }
 
   // Update game state
-  void Update(float dt) {
-      // Always update starfield
-      UpdateStarfield(dt);
-
+  void Update(float dt, InputCommand input) {
       // Update ship hit flash timer
       if (ship.hitFlashTimer > 0) {
           ship.hitFlashTimer -= dt;
@@ -1105,115 +3847,114 @@
           return;
       }
 
+      StageTimer tickTimer(STAGE_TICK);
+
       // Increase global time so comet morph can happen
       gameTime += dt;
 
       // Power-ups
+      ProfileZone powerUpZone("power-ups");
       powerUpSpawnTimer += dt;
       if (powerUpSpawnTimer >= POWERUP_SPAWN_INTERVAL) {
-          powerUps.push_back(SpawnPowerUp());
+          SpawnPowerUp();
           powerUpSpawnTimer = 0;
       }
 
-      for (int i = powerUps.size() - 1; i >= 0; i--) {
-          PowerUp& pu = powerUps[i];
-          pu.lifetime -= dt;
-          pu.position.x += pu.velocity.x * dt;
-          pu.position.y += pu.velocity.y * dt;
+      for (int i = 0; i < EntityCount(powerUps); i++) {
+          const float radius = powerUps.radius[i];
+          powerUps.lifetime[i] -= dt;
+          powerUps.posX[i] += powerUps.velX[i] * dt;
+          powerUps.posY[i] += powerUps.velY[i] * dt;
 
           // Bounce off walls
-          if (pu.position.x - pu.radius < 0) {
-              pu.position.x = pu.radius;
-              pu.velocity.x = -pu.velocity.x;
+          if (powerUps.posX[i] - radius < 0) {
+              powerUps.posX[i] = radius;
+              powerUps.velX[i] = -powerUps.velX[i];
           }
-          if (pu.position.x + pu.radius > SCREEN_WIDTH) {
-              pu.position.x = SCREEN_WIDTH - pu.radius;
-              pu.velocity.x = -pu.velocity.x;
+          if (powerUps.posX[i] + radius > SCREEN_WIDTH) {
+              powerUps.posX[i] = SCREEN_WIDTH - radius;
+              powerUps.velX[i] = -powerUps.velX[i];
           }
-          if (pu.position.y - pu.radius < 0) {
-              pu.position.y = pu.radius;
-              pu.velocity.y = -pu.velocity.y;
+          if (powerUps.posY[i] - radius < 0) {
+              powerUps.posY[i] = radius;
+              powerUps.velY[i] = -powerUps.velY[i];
           }
-          if (pu.position.y + pu.radius > SCREEN_HEIGHT) {
-              pu.position.y = SCREEN_HEIGHT - pu.radius;
-              pu.velocity.y = -pu.velocity.y;
+          if (powerUps.posY[i] + radius > SCREEN_HEIGHT) {
+              powerUps.posY[i] = SCREEN_HEIGHT - radius;
+              powerUps.velY[i] = -powerUps.velY[i];
           }
 
-          if (pu.lifetime <= 0) {
-              powerUps.erase(powerUps.begin() + i);
+          if (powerUps.lifetime[i] <= 0) {
+              KillEntity(powerUps, i);
               continue;
           }
 
           // Check if spaceship picks it up
-          float dx = ship.position.x - pu.position.x;
-          float dy = ship.position.y - pu.position.y;
-          if (sqrt(dx*dx + dy*dy) < (ship.size/2 + pu.radius)) {
+          float dx = ship.position.x - powerUps.posX[i];
+          float dy = ship.position.y - powerUps.posY[i];
+          float pickupDist = ship.size/2 + radius;
+          if (dx*dx + dy*dy < pickupDist * pickupDist) {
               // Refill HP
               ship.hitPoints = std::min(5, ship.hitPoints + 3);
 
-              if (soundEnabled) {
-                  PlaySound(powerUpSound);
-              }
+              QueueSound(SOUND_POWERUP);
 
-              powerUps.erase(powerUps.begin() + i);
+              KillEntity(powerUps, i);
               continue;
           }
       }
 
+      powerUpZone.End();
+
       // Win condition if survive 90s and no comets left
       bool spawnAllowed = gameTime < 90.0f;
-      if (gameTime >= 60.0f && comets.empty() && !winTriggered) {
+      if (gameTime >= 60.0f && EntityCount(comets) == 0 && !winTriggered) {
           CreateHugeExplosion(ship.position.x, ship.position.y);
           winTriggered = true;
           gameState = WIN;
-          StopMusicStream(gameplayMusic);
-
-          if (soundEnabled) {
-              PlaySound(victorySound);
-          }
+          QueueSound(SOUND_VICTORY);
       }
 
       // Spaceship vs comets
-      for (size_t i = 0; i < comets.size(); i++) {
-          Comet& c = comets[i];
-          float dx = ship.position.x - c.position.x;
-          float dy = ship.position.y - c.position.y;
-          float dist = sqrt(dx*dx + dy*dy);
-
-          if (dist < ship.size + c.radius) {
+      ProfileZone shipZone("ship collisions");
+      for (int i = 0; i < EntityCount(comets); i++) {
+          float dx = ship.position.x - comets.posX[i];
+          float dy = ship.position.y - comets.posY[i];
+          float distSq = dx*dx + dy*dy;
+          float minDist = ship.size + comets.radius[i];
+
+          if (distSq < minDist * minDist) {
+              float dist = sqrtf(distSq);
               float nx = dx / dist;
               float ny = dy / dist;
-              float overlap = (ship.size + c.radius) - dist;
+              float overlap = minDist - dist;
 
               // Separate them
               ship.position.x += nx * (overlap / 2.0f);
               ship.position.y += ny * (overlap / 2.0f);
-              c.position.x -= nx * (overlap / 2.0f);
-              c.position.y -= ny * (overlap / 2.0f);
+              comets.posX[i] -= nx * (overlap / 2.0f);
+              comets.posY[i] -= ny * (overlap / 2.0f);
 
               // Bounce velocities
               ship.velocity.x = -ship.velocity.x * 0.5f;
               ship.velocity.y = -ship.velocity.y * 0.5f;
-              c.velocity.x = -c.velocity.x * 0.3f;
-              c.velocity.y = -c.velocity.y * 0.3f;
+              comets.velX[i] = -comets.velX[i] * 0.3f;
+              comets.velY[i] = -comets.velY[i] * 0.3f;
 
               // Damage spaceship
               ship.hitPoints--;
               ship.hitFlashTimer = 0.3f;
 
               if (ship.hitPoints <= 0) {
-                  comets.clear();
-                  bigComets.clear();
-                  bullets.clear();
+                  ClearEntities(comets);
+                  ClearEntities(bigComets);
+                  ClearEntities(bullets);
+                  FlushKills(powerUps);    // power-ups taken earlier this tick
                   sparks.clear();
 
                   CreateHugeExplosion(ship.position.x, ship.position.y);
                   gameState = GAMEOVER;
-                  StopMusicStream(gameplayMusic);
-
-                  if (soundEnabled) {
-                      PlaySound(defeatSound);
-                  }
+                  QueueSound(SOUND_DEFEAT);
 
                   return;
               }
@@ -1221,16 +3962,17 @@
       }
 
       // Spaceship vs big comets
-      for (size_t i = 0; i < bigComets.size(); i++) {
-          BigComet& bc = bigComets[i];
-          float dx = ship.position.x - bc.position.x;
-          float dy = ship.position.y - bc.position.y;
-          float dist = sqrt(dx*dx + dy*dy);
-
-          if (dist < ship.size * 1.2f + bc.radius) {
+      for (int i = 0; i < EntityCount(bigComets); i++) {
+          float dx = ship.position.x - bigComets.posX[i];
+          float dy = ship.position.y - bigComets.posY[i];
+          float distSq = dx*dx + dy*dy;
+          float hitDist = ship.size * 1.2f + bigComets.radius[i];
+
+          if (distSq < hitDist * hitDist) {
+              float dist = sqrtf(distSq);
               float nx = dx / dist;
               float ny = dy / dist;
-              float overlap = (ship.size + bc.radius) - dist;
+              float overlap = (ship.size + bigComets.radius[i]) - dist;
 
               ship.position.x += nx * (overlap / 2.0f);
               ship.position.y += ny * (overlap / 2.0f);
@@ -1241,36 +3983,36 @@
               ship.hitFlashTimer = 0.3f;
 
               if (ship.hitPoints <= 0) {
-                  comets.clear();
-                  bigComets.clear();
-                  bullets.clear();
+                  ClearEntities(comets);
+                  ClearEntities(bigComets);
+                  ClearEntities(bullets);
+                  FlushKills(powerUps);    // power-ups taken earlier this tick
                   sparks.clear();
 
                   CreateHugeExplosion(ship.position.x, ship.position.y);
                   gameState = GAMEOVER;
-                  StopMusicStream(gameplayMusic);
-
-                  if (soundEnabled) {
-                      PlaySound(defeatSound);
-                  }
+                  QueueSound(SOUND_DEFEAT);
 
                   return;
               }
           }
       }
 
+      shipZone.End();
+
       // Movement controls
-      if (IsKeyDown(KEY_UP)) {
+      ship.thrusting = input & INPUT_THRUST;
+      if (input & INPUT_THRUST) {
           ship.velocity.x += cos(ship.angle) * SHIP_ACCEL * dt;
           ship.velocity.y += sin(ship.angle) * SHIP_ACCEL * dt;
       }
 
-      if (IsKeyDown(KEY_DOWN)) {
+      if (input & INPUT_REVERSE) {
           ship.velocity.x -= cos(ship.angle) * SHIP_REVERSE * dt;
           ship.velocity.y -= sin(ship.angle) * SHIP_REVERSE * dt;
       }
 
-      if (IsKeyDown(KEY_SPACE)) {
+      if (input & INPUT_BRAKE) {
           // Quick brake
           float speed = sqrt(ship.velocity.x * ship.velocity.x + ship.velocity.y * ship.velocity.y);
           if (speed > 0) {
@@ -1281,11 +4023,11 @@
           }
       }
 
-      if (IsKeyDown(KEY_LEFT)) {
+      if (input & INPUT_LEFT) {
           ship.angle -= SHIP_ROT_SPEED * dt;
       }
 
-      if (IsKeyDown(KEY_RIGHT)) {
+      if (input & INPUT_RIGHT) {
           ship.angle += SHIP_ROT_SPEED * dt;
       }
 
@@ -1347,18 +4089,15 @@
               const Vector2& pos = spawnPositions[i];
               const float angle = bulletAngles[i];
 
-              Bullet bullet;
-              bullet.position = pos;
-              bullet.velocity.x = cos(angle) * BULLET_SPEED + ship.velocity.x;
-              bullet.velocity.y = sin(angle) * BULLET_SPEED + ship.velocity.y;
-              bullet.radius = BULLET_RADIUS;
-
-              bullets.push_back(bullet);
+              const int b = AddEntity(bullets);
+              bullets.posX[b] = pos.x;
+              bullets.posY[b] = pos.y;
+              bullets.velX[b] = cos(angle) * BULLET_SPEED + ship.velocity.x;
+              bullets.velY[b] = sin(angle) * BULLET_SPEED + ship.velocity.y;
+              bullets.radius[b] = BULLET_RADIUS;
           }
 
-          if (soundEnabled) {
-              PlaySound(bulletSound);
-          }
+          QueueSound(SOUND_BULLET);
 
           lastBulletTime = 0;
 
@@ -1386,88 +4125,70 @@
           }
       }
 
-      // Update bullets
-      for (int i = bullets.size() - 1; i >= 0; i--) {
-          Bullet& b = bullets[i];
-          b.position.x += b.velocity.x * dt;
-          b.position.y += b.velocity.y * dt;
-
-          // Off screen => remove
-          if (b.position.x < 0 || b.position.x > SCREEN_WIDTH ||
-              b.position.y < 0 || b.position.y > SCREEN_HEIGHT) {
-              bullets.erase(bullets.begin() + i);
-          }
-      }
-
-      // Update comets
-      for (auto& c : comets) {
-          if (c.slowEffectTimer > 0) {
-              c.slowEffectTimer -= dt;
-              if (c.slowEffectTimer < 0) c.slowEffectTimer = 0;
-          }
-
-          if (c.indestructableTimer > 0) {
-              c.indestructableTimer -= dt;
-              if (c.indestructableTimer < 0) c.indestructableTimer = 0;
-          }
-
-          if (c.hitEffectTimer > 0) {
-              c.hitEffectTimer -= dt;
-              if (c.hitEffectTimer < 0) c.hitEffectTimer = 0;
-          }
-
-          c.position.x += c.velocity.x * dt;
-          c.position.y += c.velocity.y * dt;
-          c.velocity.x *= COMET_FRICTION;
-          c.velocity.y *= COMET_FRICTION;
-
-          // Never drop below COMET_MIN_SPEED
-          float speed = sqrt(c.velocity.x * c.velocity.x + c.velocity.y * c.velocity.y);
-          if (speed < COMET_MIN_SPEED && speed > 0) {
-              float factor = COMET_MIN_SPEED / speed;
-              c.velocity.x *= factor;
-              c.velocity.y *= factor;
-          }
-
-          // Bounce off screen edges
-          if (c.position.x - c.radius < 0) {
-              c.position.x = c.radius;
-              c.velocity.x = -c.velocity.x;
-          }
-          if (c.position.x + c.radius > SCREEN_WIDTH) {
-              c.position.x = SCREEN_WIDTH - c.radius;
-              c.velocity.x = -c.velocity.x;
-          }
-          if (c.position.y - c.radius < 0) {
-              c.position.y = c.radius;
-              c.velocity.y = -c.velocity.y;
-          }
-          if (c.position.y + c.radius > SCREEN_HEIGHT) {
-              c.position.y = SCREEN_HEIGHT - c.radius;
-              c.velocity.y = -c.velocity.y;
-          }
-
-          // Update trail
-          c.trailTimer += dt;
-          if (c.trailTimer >= 0.05f) { // TRAIL_INTERVAL
-              c.trailTimer -= 0.05f;
-              c.trail.push_back((TrailPoint){c.position.x, c.position.y});
-              if (c.trail.size() > 5) {
-                  c.trail.erase(c.trail.begin());
+      // Integration runs as jobs over independent slices of each store
+      {
+          StageTimer timer(STAGE_INTEGRATE);
+
+          // Update bullets
+          ParallelFor(EntityCount(bullets), BULLET_GRAIN, [dt](int begin, int end) {
+              kernels->advance(bullets.posX.data() + begin, bullets.velX.data() + begin, end - begin, dt);
+              kernels->advance(bullets.posY.data() + begin, bullets.velY.data() + begin, end - begin, dt);
+          });
+
+          for (int i = 0; i < EntityCount(bullets); i++) {
+              // Off screen => remove
+              if (bullets.posX[i] < 0 || bullets.posX[i] > SCREEN_WIDTH ||
+                  bullets.posY[i] < 0 || bullets.posY[i] > SCREEN_HEIGHT) {
+                  KillEntity(bullets, i);
               }
           }
-      }
 
-      // Update big comets
-      for (int i = bigComets.size() - 1; i >= 0; i--) {
-          BigComet& bc = bigComets[i];
-          bc.position.x += bc.velocity.x * dt;
-          bc.position.y += bc.velocity.y * dt;
+          // Update comets, a column group at a time so each loop streams through
+          // contiguous arrays
+          ParallelFor(EntityCount(comets), COMET_GRAIN, [dt](int begin, int end) {
+              const int count = end - begin;
+              float* posX = comets.posX.data() + begin;
+              float* posY = comets.posY.data() + begin;
+              float* velX = comets.velX.data() + begin;
+              float* velY = comets.velY.data() + begin;
+              const float* radius = comets.radius.data() + begin;
+
+              // Effect timers count down to zero
+              float* slowTimers = comets.slowEffectTimer.data() + begin;
+              float* indestructableTimers = comets.indestructableTimer.data() + begin;
+              float* hitTimers = comets.hitEffectTimer.data() + begin;
+              for (int i = 0; i < count; i++) {
+                  slowTimers[i] = std::max(0.0f, slowTimers[i] - dt);
+                  indestructableTimers[i] = std::max(0.0f, indestructableTimers[i] - dt);
+                  hitTimers[i] = std::max(0.0f, hitTimers[i] - dt);
+              }
 
-          // Remove if off screen
-          if (bc.position.x < -bc.radius || bc.position.x > SCREEN_WIDTH + bc.radius ||
-              bc.position.y < -bc.radius || bc.position.y > SCREEN_HEIGHT + bc.radius) {
-              bigComets.erase(bigComets.begin() + i);
+              // Move, apply friction, hold the minimum speed and bounce off the edges
+              kernels->integrateComets(posX, posY, velX, velY, radius, count, dt);
+
+              // Update trails
+              float* trailTimers = comets.trailTimer.data() + begin;
+              CometTrail* trails = comets.trail.data() + begin;
+              for (int i = 0; i < count; i++) {
+                  trailTimers[i] += dt;
+                  if (trailTimers[i] >= COMET_TRAIL_INTERVAL) {
+                      trailTimers[i] -= COMET_TRAIL_INTERVAL;
+                      PushTrailPoint(trails[i], posX[i], posY[i]);
+                  }
+              }
+          });
+
+          // Update big comets
+          for (int i = 0; i < EntityCount(bigComets); i++) {
+              bigComets.posX[i] += bigComets.velX[i] * dt;
+              bigComets.posY[i] += bigComets.velY[i] * dt;
+
+              // Remove if off screen
+              const float r = bigComets.radius[i];
+              if (bigComets.posX[i] < -r || bigComets.posX[i] > SCREEN_WIDTH + r ||
+                  bigComets.posY[i] < -r || bigComets.posY[i] > SCREEN_HEIGHT + r) {
+                  KillEntity(bigComets, i);
+              }
           }
       }
 
@@ -1481,96 +4202,98 @@
       }
 
       // Update explosion particles
-      UpdateExplosionParticles(dt);
+      {
+          StageTimer timer(STAGE_PARTICLES);
+          UpdateExplosionParticles(dt);
+      }
 
-      // Bullets vs Comets
-      for (int i = bullets.size() - 1; i >= 0; i--) {
-          Bullet& b = bullets[i];
-          bool bulletHit = false;
+      // Bin comets for this update's collision passes
+      {
+          StageTimer timer(STAGE_BROAD_PHASE);
+          BuildGrid(cometGrid, comets);
+          BuildGrid(bigCometGrid, bigComets);
+      }
 
-          for (int j = comets.size() - 1; j >= 0; j--) {
-              Comet& c = comets[j];
+      // Collisions resolve one pair at a time, in order, since each can spawn,
+      // kill and draw random numbers that the next one sees
+      StageTimer collisionTimer(STAGE_COLLISIONS);
 
-              if (c.indestructableTimer > 0) continue;
+      // Bullets vs Comets
+      ProfileZone bulletZone("bullets vs comets");
+      for (int i = EntityCount(bullets) - 1; i >= 0; i--) {
+          if (IsKilled(bullets, i)) continue;
 
-              float dx = b.position.x - c.position.x;
-              float dy = b.position.y - c.position.y;
-              if (sqrt(dx*dx + dy*dy) < c.radius) {
-                  bulletHit = true;
+          const float bx = bullets.posX[i];
+          const float by = bullets.posY[i];
+          bool bulletHit = false;
 
-                  if (soundEnabled) {
-                      PlaySound(hitSound);
-                  }
+          int j = FindBulletTarget(bx, by);
+          if (j >= 0) {
+              bulletHit = true;
 
-                  c.hitPoints--;
+              QueueSound(SOUND_HIT);
 
-                  // Slow effect if tier 3
-                  if (c.tier == 3 && c.slowEffectTimer == 0) {
-                      c.velocity.x *= 0.66f;
-                      c.velocity.y *= 0.66f;
-                      c.slowEffectTimer = 0.5f;
-                  }
+              comets.hitPoints[j]--;
 
-                  c.hitEffectTimer = 0.5f;
-
-                  // Destroyed
-                  if (c.hitPoints <= 0) {
-                      CreateSmallExplosion(c.position.x, c.position.y);
-
-                      // If bigger than tier1 => split
-                      if (c.tier > 1) {
-                          const int newTier = c.tier - 1;
-                          const float baseSpeed = sqrt(c.velocity.x * c.velocity.x + c.velocity.y * c.velocity.y);
-                          int splits = (int)RandomRange(2, 6);
-                          const float offset = 50.0f;
-
-                          for (int k = 0; k < splits; k++) {
-                              float newAngle = RandomRange(0.0f, 2.0f * PI);
-                              float factor = RandomRange(0.7f, 0.8f);
-                              float extraFactor = RandomRange(1.2f, 1.5f);
-                              float newSpeed = baseSpeed * factor * extraFactor;
-
-                              SpawnComet(
-                                  newTier,
-                                  c.position.x + cos(newAngle) * offset,
-                                  c.position.y + sin(newAngle) * offset,
-                                  cos(newAngle) * newSpeed,
-                                  sin(newAngle) * newSpeed
-                              );
-
-                              // Short indestructable so they don't instantly collide
-                              comets.back().indestructableTimer = 0.01f;
-                          }
-                      }
+              // Slow effect if tier 3
+              if (comets.tier[j] == 3 && comets.slowEffectTimer[j] == 0) {
+                  comets.velX[j] *= 0.66f;
+                  comets.velY[j] *= 0.66f;
+                  comets.slowEffectTimer[j] = 0.5f;
+              }
 
-                      score += 10;
-                      comets.erase(comets.begin() + j);
+              comets.hitEffectTimer[j] = 0.5f;
+
+              // Destroyed
+              if (comets.hitPoints[j] <= 0) {
+                  // Stays in place until the kills are flushed, so grid indices stay valid
+                  KillEntity(comets, j);
+                  CreateSmallExplosion(comets.posX[j], comets.posY[j]);
+
+                  // If bigger than tier1 => split
+                  if (comets.tier[j] > 1) {
+                      const int newTier = comets.tier[j] - 1;
+                      const float baseSpeed = sqrt(comets.velX[j] * comets.velX[j] + comets.velY[j] * comets.velY[j]);
+                      const Vector2 origin = { comets.posX[j], comets.posY[j] };
+                      int splits = (int)RandomRange(2, 6);
+                      const float offset = 50.0f;
+
+                      for (int k = 0; k < splits; k++) {
+                          float newAngle = RandomRange(0.0f, 2.0f * PI);
+                          float factor = RandomRange(0.7f, 0.8f);
+                          float extraFactor = RandomRange(1.2f, 1.5f);
+                          float newSpeed = baseSpeed * factor * extraFactor;
+
+                          EntityHandle child = SpawnComet(
+                              newTier,
+                              origin.x + cos(newAngle) * offset,
+                              origin.y + sin(newAngle) * offset,
+                              cos(newAngle) * newSpeed,
+                              sin(newAngle) * newSpeed
+                          );
+
+                          // Short indestructable so they don't instantly collide
+                          comets.indestructableTimer[ResolveHandle(comets.handles, child)] = 0.01f;
+                      }
                   }
 
-                  break;
+                  score += 10;
               }
           }
 
           // If not hit normal comet, check big comet
           if (!bulletHit) {
-              for (int j = bigComets.size() - 1; j >= 0; j--) {
-                  BigComet& bc = bigComets[j];
-                  float dx = b.position.x - bc.position.x;
-                  float dy = b.position.y - bc.position.y;
-
-                  if (sqrt(dx*dx + dy*dy) < bc.radius) {
-                      bulletHit = true;
-                      // Big comets are indestructible
-                      break;
-                  }
-              }
+              // Big comets are indestructible
+              bulletHit = FindBulletBigCometHit(bx, by);
           }
 
           if (bulletHit) {
-              bullets.erase(bullets.begin() + i);
+              KillEntity(bullets, i);
           }
       }
 
+      bulletZone.End();
+
       // Check collisions among comets
       CheckCometCollisions();
       CheckBigCometCollisions();
@@ -1597,16 +4320,22 @@
               cometSpawnTimer = 0;
           }
       }
+
+      // Nothing holds dense indices past this point, so swap out what was killed
+      FlushKills(bullets);
+      FlushKills(comets);
+      FlushKills(bigComets);
+      FlushKills(powerUps);
   }
 
-  // Main draw function
-  void Draw() {
-      // Draw background elements
+  // Main draw function, drawing a published tick
+  void Draw(const FrameSnapshot& frame) {
+      // Draw background elements; Cronos comes from its baked layer
       DrawStarfield();
-      DrawCronos();
+      DrawBackgroundLayer(cronosLayer);
 
       // Menu state
-      if (gameState == MENU) {
+      if (frame.gameState == MENU) {
           DrawText("Splitting Comets", SCREEN_WIDTH/2 - MeasureText("Splitting Comets", 48)/2, SCREEN_HEIGHT/2 - 50, 48,
   WHITE);
           DrawText("Press ENTER to start", SCREEN_WIDTH/2 - MeasureText("Press ENTER to start", 24)/2, SCREEN_HEIGHT/2, 24,
@@ -1617,7 +4346,7 @@
   SCREEN_HEIGHT/2 + 80, 24, WHITE);
 
           char scoreText[20];
-          sprintf(scoreText, "Score: %d", score);
+          sprintf(scoreText, "Score: %d", frame.score);
           DrawText(scoreText, SCREEN_WIDTH/2 - MeasureText(scoreText, 24)/2, 40, 24, WHITE);
 
           const char* soundStatus = soundEnabled ? "ON" : "OFF";
@@ -1630,7 +4359,7 @@
       }
 
       // Settings state
-      if (gameState == SETTINGS) {
+      if (frame.gameState == SETTINGS) {
           DrawText("Settings", SCREEN_WIDTH/2 - MeasureText("Settings", 48)/2, SCREEN_HEIGHT/2 - 50, 48, WHITE);
           DrawText("Press ESC to return", SCREEN_WIDTH/2 - MeasureText("Press ESC to return", 24)/2, SCREEN_HEIGHT/2, 24,
   WHITE);
@@ -1645,49 +4374,46 @@
       }
 
       // Win state
-      if (gameState == WIN) {
+      if (frame.gameState == WIN) {
           // Draw explosion particles
-          for (const auto& p : explosionParticles) {
-              DrawCircle(p.position.x, p.position.y, p.size, p.color);
-          }
+          DrawExplosionParticles(frame.particles);
 
           DrawText("WIN!", SCREEN_WIDTH/2 - MeasureText("WIN!", 48)/2, SCREEN_HEIGHT/2, 48, GREEN);
 
           char scoreText[20];
-          sprintf(scoreText, "Score: %d", score);
+          sprintf(scoreText, "Score: %d", frame.score);
           DrawText(scoreText, SCREEN_WIDTH/2 - MeasureText(scoreText, 24)/2, 40, 24, WHITE);
           return;
       }
 
       // Game over state
-      if (gameState == GAMEOVER) {
+      if (frame.gameState == GAMEOVER) {
           // Draw explosion particles
-          for (const auto& p : explosionParticles) {
-              DrawCircle(p.position.x, p.position.y, p.size, p.color);
-          }
+          DrawExplosionParticles(frame.particles);
 
           DrawText("GAME OVER", SCREEN_WIDTH/2 - MeasureText("GAME OVER", 48)/2, SCREEN_HEIGHT/2, 48, RED);
           DrawText("Press ENTER to restart", SCREEN_WIDTH/2 - MeasureText("Press ENTER to restart", 24)/2, SCREEN_HEIGHT/2
   + 40, 24, WHITE);
 
           char scoreText[20];
-          sprintf(scoreText, "Score: %d", score);
+          sprintf(scoreText, "Score: %d", frame.score);
           DrawText(scoreText, SCREEN_WIDTH/2 - MeasureText(scoreText, 24)/2, 40, 24, WHITE);
           return;
       }
 
       // Playing state
       char scoreText[20];
-      sprintf(scoreText, "Score: %d", score);
+      sprintf(scoreText, "Score: %d", frame.score);
       DrawText(scoreText, SCREEN_WIDTH/2 - MeasureText(scoreText, 24)/2, 40, 24, WHITE);
-      DrawHealthBar();
+      DrawHealthBar(frame.ship);
       DrawMusicIcon();
 
       // Draw power-ups
-      for (const auto& pu : powerUps) {
+      for (int i = 0; i < EntityCount(frame.powerUps); i++) {
+          const Vector2 position = { frame.powerUps.posX[i], frame.powerUps.posY[i] };
           Rectangle rect = {
-              pu.position.x - POWERUP_BOX_SIZE/2,
-              pu.position.y - POWERUP_BOX_SIZE/2,
+              position.x - POWERUP_BOX_SIZE/2,
+              position.y - POWERUP_BOX_SIZE/2,
               POWERUP_BOX_SIZE,
               POWERUP_BOX_SIZE
           };
@@ -1698,23 +4424,23 @@
 
           // Draw top triangle indicator
           Vector2 triPoints[3] = {
-              {pu.position.x - POWERUP_BOX_SIZE/2, pu.position.y - POWERUP_BOX_SIZE/2},
-              {pu.position.x, pu.position.y - POWERUP_BOX_SIZE},
-              {pu.position.x + POWERUP_BOX_SIZE/2, pu.position.y - POWERUP_BOX_SIZE/2}
+              {position.x - POWERUP_BOX_SIZE/2, position.y - POWERUP_BOX_SIZE/2},
+              {position.x, position.y - POWERUP_BOX_SIZE},
+              {position.x + POWERUP_BOX_SIZE/2, position.y - POWERUP_BOX_SIZE/2}
           };
           DrawTriangle(triPoints[0], triPoints[1], triPoints[2], WHITE);
 
           // Draw "PuP" text
-          DrawText("PuP", pu.position.x - MeasureText("PuP", 14)/2, pu.position.y - 7, 14, BLACK);
+          DrawText("PuP", position.x - MeasureText("PuP", 14)/2, position.y - 7, 14, BLACK);
       }
 
       // Draw spaceship
-      DrawSpaceship();
+      DrawSpaceship(frame.ship, frame.gameTime);
 
       // Draw sparks
-      for (const auto& spark : sparks) {
-          const float noseX = ship.position.x + cos(ship.angle) * ship.size;
-          const float noseY = ship.position.y + sin(ship.angle) * ship.size;
+      for (const auto& spark : frame.sparks) {
+          const float noseX = frame.ship.position.x + cos(frame.ship.angle) * frame.ship.size;
+          const float noseY = frame.ship.position.y + sin(frame.ship.angle) * frame.ship.size;
 
           DrawLine(
               noseX, noseY,
@@ -1725,16 +4451,14 @@
       }
 
       // Draw bullets
-      for (const auto& b : bullets) {
-          DrawCircle(b.position.x, b.position.y, b.radius, WHITE);
+      for (int i = 0; i < EntityCount(frame.bullets); i++) {
+          DrawCircle(frame.bullets.posX[i], frame.bullets.posY[i], frame.bullets.radius[i], WHITE);
       }
 
       // Draw comets
-      DrawNormalComets();
-      DrawBigComets();
+      DrawNormalComets(frame.comets, frame.gameTime);
+      DrawBigComets(frame.bigComets, frame.gameTime);
 
       // Draw explosion particles
-      for (const auto& p : explosionParticles) {
-          DrawCircle(p.position.x, p.position.y, p.size, p.color);
-      }
+      DrawExplosionParticles(frame.particles);
   }
\ No newline at end of file